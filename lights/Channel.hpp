@@ -0,0 +1,267 @@
+#ifndef CHANNEL_HPP
+#define CHANNEL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <utility>
+
+#include "Scheduler.hpp"
+#include "SpinLock.hpp"
+
+/**
+ * Bounded first-in-first-out channel of values of type `T`, thread-safe and awaitable.
+ *
+ * The channel does not own its storage: it is a ring over a span provided by the caller, so that many channels can
+ * share one arena (see `LightsGraph`) and sending or receiving never allocates. Any number of threads may send. There
+ * must be a single consumer, which receives in one of three styles:
+ *
+ * - `co_await channel` from a co-routine, which suspends while the channel is empty. The co-routine is resumed by the
+ *   scheduler given on construction, or inline by the sender if there is none.
+ * - `receive()` from a thread, which blocks while the channel is empty, or `tryReceive()` which does not block.
+ * - `peek()` and `consume()` to process the values in place, without copying them out of the ring.
+ *
+ * Blocking calls wait on an atomic counter which is bumped whenever values are sent or consumed, they do not spin.
+ */
+template <typename T>
+class Channel {
+   public:
+    /// Create an unbound channel, which must be bound to storage with `bind` before it is used.
+    Channel() = default;
+
+    /// Create a channel holding up to `storage.size()` values in `storage`, resume receivers using `scheduler`.
+    explicit Channel(std::span<T> storage, Scheduler* scheduler = nullptr) noexcept {
+        bind(storage, scheduler);
+    }
+
+    /// Default destructor. A co-routine still awaiting a value is not destroyed, it is owned by whoever started it.
+    ~Channel() = default;
+
+    Channel(Channel const&) = delete;
+    Channel(Channel&&) = delete;
+    Channel& operator=(Channel const&) = delete;
+    Channel& operator=(Channel&&) = delete;
+
+    /// Use `storage` for the values, resume receivers using `scheduler`. Must be called before the channel is used.
+    void bind(std::span<T> storage, Scheduler* scheduler = nullptr) noexcept {
+        assert(!storage.empty() && "Channel without storage");
+        m_storage = storage;
+        m_scheduler = scheduler;
+    }
+
+    /// Number of values that fit into the channel.
+    [[nodiscard]] size_t capacity() const noexcept {
+        return m_storage.size();
+    }
+
+    /// Number of values currently queued.
+    [[nodiscard]] size_t size() const noexcept {
+        std::lock_guard<SpinLock> const lock{m_lock};
+        return m_size;
+    }
+
+    /// Return true if no values are queued.
+    [[nodiscard]] bool empty() const noexcept {
+        return size() == 0;
+    }
+
+    /// Send a value unless the channel is full, return `true` if the value was sent.
+    bool trySend(T value) noexcept {
+        std::coroutine_handle<> receiver;
+        {
+            std::lock_guard<SpinLock> const lock{m_lock};
+            if (m_size == m_storage.size()) {
+                return false;
+            }
+            receiver = push(std::move(value));
+        }
+        signal();
+        wake(receiver);
+        return true;
+    }
+
+    /**
+     * Send a value, or merge it into the newest queued value if the channel is full. Never blocks.
+     *
+     * `merge(newest, value)` is called with the lock held and must update `newest` in place. Return `true` if the value
+     * was sent, `false` if it was merged.
+     */
+    template <typename Merge>
+    bool sendOrMerge(T value, Merge&& merge) noexcept {
+        std::coroutine_handle<> receiver;
+        {
+            std::lock_guard<SpinLock> const lock{m_lock};
+            if (m_size == m_storage.size()) {
+                // the channel is full, so no receiver is waiting
+                std::forward<Merge>(merge)(m_storage[index(m_size - 1)], std::move(value));
+                return false;
+            }
+            receiver = push(std::move(value));
+        }
+        signal();
+        wake(receiver);
+        return true;
+    }
+
+    /// Send a value, block while the channel is full.
+    void send(T value) noexcept {
+        while (true) {
+            auto const epoch = m_epoch.load(std::memory_order_acquire);
+            if (trySend(value)) {
+                return;
+            }
+            m_epoch.wait(epoch, std::memory_order_acquire);
+        }
+    }
+
+    /// Receive a value unless the channel is empty.
+    std::optional<T> tryReceive() noexcept {
+        std::optional<T> value;
+        {
+            std::lock_guard<SpinLock> const lock{m_lock};
+            if (m_size == 0) {
+                return value;
+            }
+            value = take();
+        }
+        signal();
+        return value;
+    }
+
+    /// Receive a value, block while the channel is empty.
+    T receive() noexcept {
+        while (true) {
+            auto const epoch = m_epoch.load(std::memory_order_acquire);
+            if (auto value = tryReceive()) {
+                return *std::move(value);
+            }
+            m_epoch.wait(epoch, std::memory_order_acquire);
+        }
+    }
+
+    /**
+     * Return the queued values which are stored contiguously, at the front of the channel.
+     *
+     * The values stay in the channel until they are `consume`d, senders do not overwrite them. If the queued values
+     * wrap around the end of the storage, only the first part is returned; consume it and peek again for the rest.
+     */
+    [[nodiscard]] std::span<T const> peek() const noexcept {
+        std::lock_guard<SpinLock> const lock{m_lock};
+        return std::span<T const>{m_storage}.subspan(m_head, std::min(m_size, m_storage.size() - m_head));
+    }
+
+    /// Remove `count` values from the front of the channel, after they were processed in place with `peek`.
+    void consume(size_t count) noexcept {
+        {
+            std::lock_guard<SpinLock> const lock{m_lock};
+            assert(count <= m_size && "Consume more than queued");
+            m_head += count;
+            if (m_head >= m_storage.size()) {
+                m_head -= m_storage.size();
+            }
+            m_size -= count;
+        }
+        signal();
+    }
+
+    /// Awaiter returned by `co_await channel`, yields the next value.
+    class Receiver {
+       public:
+        explicit Receiver(Channel& channel) noexcept : m_channel{channel} {}
+
+        /// return true if a value is queued, the co-routine does not suspend in that case
+        [[nodiscard]] bool await_ready() const noexcept {
+            return !m_channel.empty();
+        }
+
+        /// suspend until a value is sent, unless one was sent in the meantime
+        bool await_suspend(std::coroutine_handle<> awaitingCoroutine) noexcept {
+            std::lock_guard<SpinLock> const lock{m_channel.m_lock};
+            if (m_channel.m_size > 0) {
+                return false;
+            }
+            assert(!m_channel.m_receiver && "Second co-routine awaiting");
+            m_channel.m_receiver = awaitingCoroutine;
+            return true;
+        }
+
+        /// take the value on resume, there is one since there is only one consumer
+        T await_resume() noexcept {
+            return *m_channel.tryReceive();
+        }
+
+       private:
+        /// the channel to receive from
+        Channel& m_channel;
+    };
+
+    /// Receive the next value from a co-routine.
+    Receiver operator co_await() noexcept {
+        return Receiver{*this};
+    }
+
+   private:
+    /// index in `m_storage` of the value at `offset` from the front
+    [[nodiscard]] size_t index(size_t offset) const noexcept {
+        auto const index = m_head + offset;
+        return index >= m_storage.size() ? index - m_storage.size() : index;
+    }
+
+    /// append a value and return the co-routine to wake, if any; must be called with lock held and space available
+    std::coroutine_handle<> push(T value) noexcept {
+        m_storage[index(m_size)] = std::move(value);
+        ++m_size;
+        return std::exchange(m_receiver, {});
+    }
+
+    /// remove and return the front value; must be called with lock held and a value queued
+    T take() noexcept {
+        T value = std::move(m_storage[m_head]);
+        if (++m_head == m_storage.size()) {
+            m_head = 0;
+        }
+        --m_size;
+        return value;
+    }
+
+    /// wake up threads blocked in `send` or `receive`
+    void signal() noexcept {
+        m_epoch.fetch_add(1, std::memory_order_release);
+        m_epoch.notify_all();
+    }
+
+    /// resume the co-routine which was awaiting a value, if any
+    void wake(std::coroutine_handle<> receiver) {
+        if (!receiver) {
+            return;
+        }
+        if (m_scheduler != nullptr) {
+            m_scheduler->schedule(receiver);
+        } else {
+            receiver.resume();
+        }
+    }
+
+    /// the values, used as a ring
+    std::span<T> m_storage;
+    /// the scheduler used to resume the receiving co-routine, `nullptr` to resume inline
+    Scheduler* m_scheduler{};
+    /// protects the members below
+    mutable SpinLock m_lock;
+    /// index of the front value
+    size_t m_head{};
+    /// number of values queued
+    size_t m_size{};
+    /// co-routine suspended waiting for a value
+    std::coroutine_handle<> m_receiver;
+    /// bumped whenever values are sent or consumed, blocking calls wait for it to change
+    std::atomic<uint32_t> m_epoch{0};
+};
+
+#endif  // CHANNEL_HPP
@@ -1,41 +1,89 @@
 #include "CoRoutineLights.hpp"
 
+#include <array>
 #include <cstdint>
-#include <iostream>
+#include <memory_resource>
+#include <stdexcept>
 #include <vector>
 
+#include "StateTable.hpp"
+#include "TableSlot.hpp"
+#include "Task.hpp"
+
 void CoRoutineLights::processInput(uint32_t input) {
+    LatencyProbe const probe{*this};
+    // makes the guard of the co-routine a cheap nested one if it is resumed by this thread
+    TableSlot::ReadGuard const guard{};
     m_input.set(input);
 }
 
+void CoRoutineLights::restore(LightsState const& state) {
+    checkRestore(state, hasTable());
+    if (!m_input.ready()) {
+        throw std::logic_error{"Cannot restore lights while inputs are pending"};
+    }
+    initTable(state.table);
+    restoreLights(state.lights);
+    m_task = {};
+    m_input.reset();
+    m_task = run(m_input.resource());
+    m_task.start();
+}
+
 // NOLINTBEGIN: readability-static-accessed-through-instance (clang tidy seems to be distracted by co-routines)
+// GCC warns that the frame allocated by the placement `operator new` of `FrameAllocation` is freed by the usual
+// `operator delete`, but that is how co-routine frames are freed by the standard ([dcl.fct.def.coroutine])
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
 /**
  * State variable (m_state) is replaced by implicit co-routine frame.
  *
  * Member variables (m_len, m_lightsVec) are replaced by local variables (len, lightsVec) - could also be member
- * variables.
+ * variables. During INIT, the states of `lightsVec` are collected in a buffer inside the co-routine frame if they fit,
+ * otherwise they are allocated from `frameResource`; then they are interned and RUN uses the shared table. A restored
+ * instance starts with the table set and skips INIT. RUN reads the table for every input, so that it can be replaced.
  *
  * Input value (input) is replaced by awaitable (m_input)
  */
-CoRoutineLights::Task CoRoutineLights::run() noexcept {
-    // INIT, part 0
-    auto len = co_await m_input;
-    std::vector<uint32_t> lightsVec{};
-    lightsVec.reserve(len);
-    // INIT, part 1
-    for (int i = 0; i < len; ++i) {
-        lightsVec.push_back(co_await m_input);
+Task<> CoRoutineLights::run(std::pmr::memory_resource* frameResource) noexcept {
+    if (!hasTable()) {
+        // INIT, part 0
+        auto len = co_await m_input;
+        count(Counter::InitInputs);
+#if LIGHTS_INLINE_STATES > 0
+        std::array<uint32_t, LIGHTS_INLINE_STATES> tableBuffer;  // NOLINT(cppcoreguidelines-pro-type-member-init)
+        std::pmr::monotonic_buffer_resource tableResource{tableBuffer.data(), sizeof(tableBuffer), frameResource};
+        std::pmr::vector<uint32_t> lightsVec{&tableResource};
+#else
+        std::pmr::vector<uint32_t> lightsVec{frameResource};
+#endif
+        lightsVec.reserve(len);
+        // INIT, part 1
+        for (int i = 0; i < len; ++i) {
+            lightsVec.push_back(co_await m_input);
+            count(Counter::InitInputs);
+        }
+        initTable(StateTableRegistry::instance().intern(lightsVec));
     }
 
     // RUN
     while (true) {
         auto input = co_await m_input;
-        if (input < lightsVec.size()) {
-            setLights(lightsVec[input]);
+        count(Counter::RunInputs);
+        // the guard ends before the next `co_await`
+        TableSlot::ReadGuard const guard{};
+        auto const& states = table();
+        if (input < states.size()) {
+            setLights(states[input]);
         } else {
-            std::cout << "Out of bounds: " << input << " >= " << lightsVec.size() << "\n";
+            reportOutOfBounds(input, states.size());
         }
     }
 }
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
 
 // NOLINTEND: readability-static-accessed-through-instance
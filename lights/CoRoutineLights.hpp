@@ -3,32 +3,63 @@
 
 #include <cassert>
 #include <coroutine>
+#include <cstddef>
 #include <cstdint>
+#include <memory_resource>
+#include <mutex>
+#include <span>
+#include <vector>
 
+#include "FramePool.hpp"
+#include "Task.hpp"
 #include "Lights.hpp"
+#include "Scheduler.hpp"
+#include "SpinLock.hpp"
+#include "StateTable.hpp"
+#include "TableSlot.hpp"
+
+#ifndef LIGHTS_INLINE_STATES
+/// Number of states stored inline in the co-routine frame, `0` to always allocate the state table separately.
+#define LIGHTS_INLINE_STATES 8
+#endif
 
 /**
  * Implementation of lights using co-routines.
  *
- * This implementation is not thread-safe. It allows a sequential, yet non-blocking implementation of the lights
- * state-machine.
+ * This implementation allows a sequential, yet non-blocking implementation of the lights state-machine. Inputs may be
+ * provided from any thread, the co-routine is resumed by one thread at a time.
  *
- * When a new instance is constructed, the run method is invoked and runs until it waits for an input. Whenever a new
- * input is provided via the `processInput` method, the co-routine resumes and consumes the input in the thread of the
- * caller of `processInput`.
+ * When a new instance is constructed, the run method is started and runs until it waits for an input. Whenever a new
+ * input is provided via the `processInput` method, the input is queued and the co-routine resumes. Without a scheduler,
+ * the co-routine is resumed inline and consumes the input in the thread of the caller of `processInput`. With a
+ * scheduler (see `LightsExecutor` or `WorkStealingPool`), the co-routine is handed to the scheduler and consumes all
+ * inputs queued in the meantime once it is resumed. The instance owns the `Task` of `run`, and thereby any sub-tasks
+ * `run` awaits.
  *
- * The co-routine frame is allocated on the heap.
+ * The co-routine frame is allocated from a memory resource, by default the process-wide `FramePool`, so that creating
+ * and destroying instances does not hit the global heap once the pool has warmed up. State tables with up to
+ * `LIGHTS_INLINE_STATES` states are stored inside the co-routine frame, larger ones are allocated from the same memory
+ * resource.
  *
  * See https://lewissbaker.github.io/2017/11/17/understanding-operator-co-await
  */
-class CoRoutineLights : public Lights {
+class CoRoutineLights final : public Lights {
    public:
-    /// Create a new co-routine lights instance and start its internal co-routine.
-    CoRoutineLights() {
-        run();
+    /**
+     * Create a new co-routine lights instance and start its internal co-routine.
+     *
+     * If a `scheduler` is given, the co-routine is resumed by that scheduler, otherwise it is resumed inline by
+     * `processInput`. If a `frameResource` is given (e.g. a caller supplied arena), the co-routine frame, the state table
+     * and the input queue are allocated from it, otherwise they are allocated from `FramePool::instance()`. The resource
+     * must outlive the instance.
+     */
+    explicit CoRoutineLights(Scheduler* scheduler = nullptr, std::pmr::memory_resource* frameResource = nullptr)
+        : m_input{*this, scheduler, frameResource != nullptr ? frameResource : &FramePool::instance()},
+          m_task{run(frameResource != nullptr ? frameResource : &FramePool::instance())} {
+        m_task.start();
     }
 
-    /// default destructor, this is here to satisfy the "rule of five"
+    /// default destructor, destroys the co-routine before the input it may be waiting for
     ~CoRoutineLights() override = default;
 
     /// Deleted copy constructor, type is not copyable.
@@ -43,55 +74,43 @@ class CoRoutineLights : public Lights {
     /// This type is move-assignable, type is not movable. Running co-routine would refer to original object.
     CoRoutineLights& operator=(CoRoutineLights&&) = delete;
 
-    /**
-     * Provide an input.
-     *
-     * Must only be called when object is ready, i.e., `ready()` yields `true`.
-     */
+    /// Provide an input. The input is queued if the co-routine is not waiting for input.
     void processInput(uint32_t input) override;
 
-    /// Check whether object is ready to accept inputs
+    /// Provide several inputs at once. The co-routine is resumed at most once to consume all of them.
+    void processInputs(std::span<uint32_t const> inputs) override {
+        TableSlot::ReadGuard const guard{};
+        m_input.set(inputs);
+    }
+
+    /// Check whether the co-routine is idle, i.e., waiting for input with no inputs queued
     [[nodiscard]] bool ready() const noexcept {
         return m_input.ready();
     }
 
-   private:
-    /// Return object created by invoking run method
-    struct Task {
-        struct promise_type {
-            static Task get_return_object() noexcept {
-                return {};
-            }
-
-            static std::suspend_never initial_suspend() noexcept {
-                return {};
-            }
-
-            static std::suspend_never final_suspend() noexcept {
-                return {};
-            }
-
-            void return_void() noexcept {}
+    [[nodiscard]] LightsState save() const override {
+        return {tableRef(), getLights()};
+    }
 
-            void unhandled_exception() noexcept {}
-        };
-    };
+    /// Restore, the co-routine is restarted in RUN. Throws `std::logic_error` if the co-routine is not idle.
+    void restore(LightsState const& state) override;
 
-    /// Start the co-routine, proceed as inputs are provided through `processInput`
-    Task run() noexcept;
+   private:
+    /// Run INIT, unless restored, then RUN; proceed as inputs are provided; allocate from `frameResource`
+    Task<> run(std::pmr::memory_resource* frameResource) noexcept;
 
     /// Input type is Awaitable and Awaiter object
     class Input {
        public:
-        /// Constructor.
-        Input() noexcept = default;
+        /**
+         * Constructor. Resume awaiting co-routine using `scheduler`, or inline if `scheduler` is `nullptr`. Queued values
+         * are stored in memory allocated from `resource`. Resumes are counted in the counters of `owner`.
+         */
+        Input(CoRoutineLights& owner, Scheduler* scheduler, std::pmr::memory_resource* resource) noexcept
+            : m_owner{owner}, m_scheduler{scheduler}, m_values{resource} {}
 
-        /// Destructor. Destroys the internal co-routine handle, if it exists.
-        ~Input() {
-            if (m_awaitingCoroutine) {
-                m_awaitingCoroutine.destroy();
-            }
-        }
+        /// Destructor. The awaiting co-routine is owned by the task of `run`, which must be destroyed first.
+        ~Input() = default;
 
         /// Deleted copy constructor, type is not copyable.
         Input(Input const&) = delete;
@@ -102,50 +121,123 @@ class CoRoutineLights : public Lights {
         /// Deleted move constructor, type is not movable. Running co-routine would refer to original object.
         Input& operator=(Input&&) = delete;
 
-        /// return false, type is never considered ready when co_await is called
-        static bool await_ready() noexcept {
-            return false;
+        /// return true if a value is queued, the co-routine does not suspend in that case
+        bool await_ready() noexcept {
+            std::lock_guard<SpinLock> const lock{m_lock};
+            return take();
         }
 
-        /// return true, always suspend until new data is received
+        /// suspend until new data is received, unless a value was queued in the meantime
         bool await_suspend(std::coroutine_handle<> awaitingCoroutine) noexcept {
-            assert(!m_awaitingCoroutine && "Second co-routine awaiting");
-            m_awaitingCoroutine = awaitingCoroutine;
+            std::lock_guard<SpinLock> const lock{m_lock};
+            if (take()) {
+                return false;
+            }
+            assert(!m_waiting && "Second co-routine awaiting");
+            m_coroutine = awaitingCoroutine;
+            m_waiting = true;
             return true;
         }
 
-        /// return value on resume
-        uint32_t await_resume() noexcept {
-            // no-body waiting, re-set to avoid handle to un-suspended co-routine being used
-            m_awaitingCoroutine = nullptr;
+        /// return value on resume, count the resume if the co-routine was suspended
+        [[nodiscard]] uint32_t await_resume() noexcept {
+            // no lock needed: `m_resumed` was set before the co-routine was resumed
+            if (m_resumed) {
+                m_resumed = false;
+                m_owner.count(Counter::Resumes);
+            }
             return m_value;
         }
 
-        /**
-         * Set value and resume awaiting co-routine
-         *
-         * This must only be called, when there is a co-routine awaiting, i.e., `ready()` yields `true`
-         */
-        void set(uint32_t value) noexcept {
-            assert(m_awaitingCoroutine && "No co-routine awaiting");
-            m_value = value;
-            m_awaitingCoroutine.resume();
+        /// Queue value and resume awaiting co-routine, if any.
+        void set(uint32_t value) {
+            set(std::span<uint32_t const>{&value, 1});
+        }
+
+        /// Queue values and resume awaiting co-routine, if any. The co-routine consumes all values before it suspends.
+        void set(std::span<uint32_t const> values) {
+            if (values.empty()) {
+                return;
+            }
+            {
+                std::lock_guard<SpinLock> const lock{m_lock};
+                if (!m_waiting) {
+                    // co-routine is running or scheduled, it will consume the values before it suspends again
+                    m_values.insert(m_values.end(), values.begin(), values.end());
+                    return;
+                }
+                // co-routine is waiting, so there are no values queued: hand over the first value directly
+                m_value = values.front();
+                m_values.insert(m_values.end(), values.begin() + 1, values.end());
+                m_waiting = false;
+                m_resumed = true;
+            }
+            if (m_scheduler != nullptr) {
+                m_scheduler->schedule(m_coroutine);
+            } else {
+                m_coroutine.resume();
+            }
         }
 
         /// Return true if there is a co-routine awaiting on this `Input`
         [[nodiscard]] bool ready() const noexcept {
-            return static_cast<bool>(m_awaitingCoroutine);
+            std::lock_guard<SpinLock> const lock{m_lock};
+            return m_waiting;
+        }
+
+        /// Forget the awaiting co-routine and drop queued values, so that a new co-routine can await this `Input`.
+        void reset() noexcept {
+            std::lock_guard<SpinLock> const lock{m_lock};
+            m_coroutine = {};
+            m_waiting = false;
+            m_values.clear();
+            m_next = 0;
+        }
+
+        /// The memory resource queued values are allocated from.
+        [[nodiscard]] std::pmr::memory_resource* resource() const noexcept {
+            return m_values.get_allocator().resource();
         }
 
        private:
-        /// the handle of the co-routine awaiting for input
-        std::coroutine_handle<> m_awaitingCoroutine;
-        /// the current input value
+        /// take the next queued value into `m_value`, return false if there is none; must be called with lock held
+        bool take() noexcept {
+            if (m_next == m_values.size()) {
+                return false;
+            }
+            m_value = m_values[m_next++];
+            if (m_next == m_values.size()) {
+                // all values consumed, re-use storage
+                m_values.clear();
+                m_next = 0;
+            }
+            return true;
+        }
+
+        /// the lights counting resumes
+        CoRoutineLights& m_owner;
+        /// the scheduler used to resume the co-routine, `nullptr` to resume inline
+        Scheduler* m_scheduler;
+        /// protects all members below, inputs may be provided from any thread
+        mutable SpinLock m_lock;
+        /// the handle of the co-routine waiting for this input, `run` or a sub-task it awaits
+        std::coroutine_handle<> m_coroutine;
+        /// true if the co-routine is suspended waiting for a value
+        bool m_waiting{false};
+        /// true if the co-routine was handed a value while waiting and has not consumed it yet
+        bool m_resumed{false};
+        /// the value to return on resume
         uint32_t m_value{};
+        /// queued values, storage is re-used once all values are consumed
+        std::pmr::vector<uint32_t> m_values;
+        /// index of next value to consume
+        size_t m_next{};
     };
 
     /// Awaitable/Awaiter object to send dato to co-routine
     Input m_input;
+    /// the task of `run`, owns the co-routine frames; declared last to be destroyed first
+    Task<> m_task;
 };
 
 #endif  // COROUTINELIGHTS_HPP
@@ -0,0 +1,144 @@
+#include "Fiber.hpp"
+
+#include <cassert>
+#include <cstdint>
+#include <exception>
+#include <utility>
+
+#if defined(__x86_64__)
+extern "C" {
+/// save the callee-saved registers on the current stack, store the stack pointer in `save`, continue on `load`
+void lights_fiber_switch(void** save, void* load) noexcept;
+/// first return address of a new fiber, calls `r13(r12)`
+void lights_fiber_start() noexcept;
+}
+
+// System V ABI: rbx, rbp, r12 - r15, the MXCSR control bits and the x87 control word are callee-saved, everything else
+// is saved by the compiler around the call to `lights_fiber_switch`
+asm(R"(
+    .text
+    .p2align 4
+    .globl lights_fiber_switch
+    .hidden lights_fiber_switch
+    .type lights_fiber_switch, @function
+lights_fiber_switch:
+    .cfi_startproc
+    pushq %rbp
+    pushq %rbx
+    pushq %r12
+    pushq %r13
+    pushq %r14
+    pushq %r15
+    subq $8, %rsp
+    stmxcsr (%rsp)
+    fnstcw 4(%rsp)
+    movq %rsp, (%rdi)
+    movq %rsi, %rsp
+    ldmxcsr (%rsp)
+    fldcw 4(%rsp)
+    addq $8, %rsp
+    popq %r15
+    popq %r14
+    popq %r13
+    popq %r12
+    popq %rbx
+    popq %rbp
+    ret
+    .cfi_endproc
+    .size lights_fiber_switch, .-lights_fiber_switch
+
+    .p2align 4
+    .globl lights_fiber_start
+    .hidden lights_fiber_start
+    .type lights_fiber_start, @function
+lights_fiber_start:
+    .cfi_startproc
+    .cfi_undefined rip
+    movq %r12, %rdi
+    callq *%r13
+    ud2
+    .cfi_endproc
+    .size lights_fiber_start, .-lights_fiber_start
+)");
+
+namespace {
+/// default MXCSR (all exceptions masked, round to nearest) in the low half, default x87 control word in the high half
+constexpr uint64_t DEFAULT_CONTROL_WORDS = (uint64_t{0x037F} << 32U) | uint64_t{0x1F80};
+}  // namespace
+#else
+namespace {
+/// entry point for `makecontext`, which only passes `int` arguments: reassemble the pointers and call `enter(fiber)`
+void startContext(unsigned enterHigh, unsigned enterLow, unsigned fiberHigh, unsigned fiberLow) {
+    auto const enter = (uintptr_t{enterHigh} << 32U) | enterLow;
+    auto const fiber = (uintptr_t{fiberHigh} << 32U) | fiberLow;
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast,performance-no-int-to-ptr): see above
+    reinterpret_cast<void (*)(void*)>(enter)(reinterpret_cast<void*>(fiber));
+}
+}  // namespace
+#endif
+
+// NOLINTBEGIN(cppcoreguidelines-pro-type-reinterpret-cast,cppcoreguidelines-pro-bounds-pointer-arithmetic): stacks
+Fiber::Fiber(Function function, void* argument, StackPool& pool)
+    : m_pool{pool}, m_stack{pool.allocate()}, m_function{function}, m_argument{argument} {
+#if defined(__x86_64__)
+    // initial frame as pushed by `lights_fiber_switch`, it "returns" to `lights_fiber_start` with the stack pointer at
+    // the 16 byte aligned top of the stack
+    auto* frame = reinterpret_cast<uint64_t*>(m_stack.base + m_stack.size) - 8;
+    frame[0] = DEFAULT_CONTROL_WORDS;
+    frame[1] = 0;                                                 // r15
+    frame[2] = 0;                                                 // r14
+    frame[3] = reinterpret_cast<uint64_t>(&Fiber::enter);         // r13
+    frame[4] = reinterpret_cast<uint64_t>(this);                  // r12
+    frame[5] = 0;                                                 // rbx
+    frame[6] = 0;                                                 // rbp
+    frame[7] = reinterpret_cast<uint64_t>(&lights_fiber_start);  // return address
+    m_stackPointer = frame;
+#else
+    getcontext(&m_context);
+    m_context.uc_stack.ss_sp = m_stack.base;
+    m_context.uc_stack.ss_size = m_stack.size;
+    m_context.uc_link = nullptr;
+    auto const enter = reinterpret_cast<uintptr_t>(&Fiber::enter);
+    auto const fiber = reinterpret_cast<uintptr_t>(this);
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+    makecontext(&m_context, reinterpret_cast<void (*)()>(&startContext), 4, static_cast<unsigned>(enter >> 32U),
+                static_cast<unsigned>(enter), static_cast<unsigned>(fiber >> 32U), static_cast<unsigned>(fiber));
+#endif
+}
+// NOLINTEND(cppcoreguidelines-pro-type-reinterpret-cast,cppcoreguidelines-pro-bounds-pointer-arithmetic)
+
+Fiber::~Fiber() {
+    m_pool.deallocate(m_stack);
+}
+
+void Fiber::resume() {
+    assert(!m_finished && "Resume finished fiber");
+#if defined(__x86_64__)
+    lights_fiber_switch(&m_callerStackPointer, m_stackPointer);
+#else
+    swapcontext(&m_callerContext, &m_context);
+#endif
+    if (m_exception) {
+        std::rethrow_exception(std::exchange(m_exception, nullptr));
+    }
+}
+
+void Fiber::suspend() noexcept {
+#if defined(__x86_64__)
+    lights_fiber_switch(&m_stackPointer, m_callerStackPointer);
+#else
+    swapcontext(&m_context, &m_callerContext);
+#endif
+}
+
+void Fiber::enter(Fiber* fiber) noexcept {
+    try {
+        fiber->m_function(fiber->m_argument);
+    } catch (...) {
+        fiber->m_exception = std::current_exception();
+    }
+    fiber->m_finished = true;
+    fiber->suspend();
+    // a finished fiber is never resumed
+    std::terminate();
+}
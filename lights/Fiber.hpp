@@ -0,0 +1,83 @@
+#ifndef FIBER_HPP
+#define FIBER_HPP
+
+#include <exception>
+
+#include "StackPool.hpp"
+
+#if !defined(__x86_64__)
+#include <ucontext.h>
+#endif
+
+/**
+ * User-space thread with its own stack (stackful co-routine).
+ *
+ * A fiber runs a function on a stack taken from a `StackPool`. `resume` switches from the caller to the fiber, which
+ * runs until it calls `suspend` or its function returns; then control switches back to the caller of `resume`. Unlike
+ * stackless co-routines, a fiber may suspend from any depth of nested calls, and unlike threads, switching is a plain
+ * function call which saves and restores a handful of registers, no kernel is involved.
+ *
+ * On x86-64 the switch is hand-written assembly (callee-saved registers, MXCSR and x87 control word), elsewhere it
+ * falls back to `swapcontext`, which is much slower since it saves and restores the signal mask with a system call.
+ *
+ * A fiber is not thread-safe: it must be resumed by one thread at a time. Exceptions escaping the fiber's function are
+ * rethrown by `resume`. A fiber should have finished before it is destroyed, objects on its stack are not destroyed
+ * otherwise.
+ */
+class Fiber {
+   public:
+    /// Function executed by a fiber, called with the argument given on construction.
+    using Function = void (*)(void* argument);
+
+    /// Prepare a fiber running `function(argument)` on a stack from `pool`. The function starts on the first `resume`.
+    explicit Fiber(Function function, void* argument, StackPool& pool = StackPool::instance());
+
+    /// Return the stack to the pool.
+    ~Fiber();
+
+    Fiber(Fiber const&) = delete;
+    Fiber(Fiber&&) = delete;
+    Fiber& operator=(Fiber const&) = delete;
+    Fiber& operator=(Fiber&&) = delete;
+
+    /// Run the fiber until it suspends or finishes. Must not be called from the fiber itself or after it finished.
+    void resume();
+
+    /// Switch back to the caller of `resume`. Must be called from the fiber.
+    void suspend() noexcept;
+
+    /// Return true once the fiber's function returned.
+    [[nodiscard]] bool finished() const noexcept {
+        return m_finished;
+    }
+
+   private:
+    /// first function executed on the fiber's stack
+    static void enter(Fiber* fiber) noexcept;
+
+    /// the pool owning the stack
+    StackPool& m_pool;
+    /// the stack
+    StackPool::Stack m_stack;
+    /// the function to run
+    Function m_function;
+    /// the argument passed to `m_function`
+    void* m_argument;
+    /// exception escaped from `m_function`, rethrown by `resume`
+    std::exception_ptr m_exception;
+    /// true once `m_function` returned
+    bool m_finished{false};
+#if defined(__x86_64__)
+    /// saved stack pointer of the fiber while it is suspended
+    void* m_stackPointer{};
+    /// saved stack pointer of the caller of `resume` while the fiber runs
+    void* m_callerStackPointer{};
+#else
+    /// saved context of the fiber while it is suspended
+    ucontext_t m_context{};
+    /// saved context of the caller of `resume` while the fiber runs
+    ucontext_t m_callerContext{};
+#endif
+};
+
+#endif  // FIBER_HPP
@@ -0,0 +1,99 @@
+#include "FiberLights.hpp"
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "StateTable.hpp"
+#include "TableSlot.hpp"
+
+FiberLights::FiberLights(StackPool& pool)
+    : m_fiber{[](void* self) { static_cast<FiberLights*>(self)->run(); }, this, pool} {
+    m_fiber.resume();
+}
+
+FiberLights::~FiberLights() {
+    m_interrupt = true;
+    m_fiber.resume();
+}
+
+void FiberLights::processInput(uint32_t input) {
+    LatencyProbe const probe{*this};
+    processInputs(std::span<uint32_t const>{&input, 1});
+}
+
+void FiberLights::processInputs(std::span<uint32_t const> inputs) {
+    if (inputs.empty()) {
+        return;
+    }
+    m_inputs = inputs;
+    count(Counter::Resumes);
+    // makes the guards of the fiber cheap nested ones
+    TableSlot::ReadGuard const guard{};
+    m_fiber.resume();
+}
+
+void FiberLights::restore(LightsState const& state) {
+    checkRestore(state, hasTable());
+    initTable(state.table);
+    m_restore = true;
+    restoreLights(state.lights);
+    m_fiber.resume();
+}
+
+uint32_t FiberLights::get() {
+    // suspend until the caller provides inputs or interrupts; the span is only valid until the fiber suspends, so all
+    // inputs are consumed before that
+    while (m_inputs.empty()) {
+        if (m_interrupt) {
+            throw Interrupted{};
+        }
+        if (m_restore) {
+            m_restore = false;
+            throw Restored{};
+        }
+        m_fiber.suspend();
+    }
+    auto const input = m_inputs.front();
+    m_inputs = m_inputs.subspan(1);
+    return input;
+}
+
+void FiberLights::run() {
+    try {
+        init();
+
+        // RUN, the table is read for every input so that it can be replaced; the guard ends before `get` suspends
+        while (true) {
+            auto input = get();
+            count(Counter::RunInputs);
+            TableSlot::ReadGuard const guard{};
+            auto const& states = table();
+            if (input < states.size()) {
+                setLights(states[input]);
+            } else {
+                reportOutOfBounds(input, states.size());
+            }
+        }
+    } catch (Interrupted) {
+        record(TransitionEvent::Kind::Interrupted, 0, 0);
+    }
+}
+
+void FiberLights::init() {
+    try {
+        // INIT, part 0
+        auto len = get();
+        count(Counter::InitInputs);
+        std::vector<uint32_t> lightsVec{};
+        lightsVec.reserve(len);
+        // INIT, part 1
+        for (uint32_t i = 0; i < len; ++i) {
+            lightsVec.push_back(get());
+            count(Counter::InitInputs);
+        }
+        initTable(StateTableRegistry::instance().intern(lightsVec));
+    } catch (Restored) {
+        // the table was set by `restore`
+    }
+}
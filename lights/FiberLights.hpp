@@ -0,0 +1,71 @@
+#ifndef FIBERLIGHTS_HPP
+#define FIBERLIGHTS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+#include "Fiber.hpp"
+#include "Lights.hpp"
+#include "StateTable.hpp"
+#include "StackPool.hpp"
+
+/**
+ * Implementation of lights using a fiber (green thread).
+ *
+ * The `run()` method is written in the same sequential, blocking style as in `ThreadLights`, but it runs on a fiber
+ * with a small stack from a `StackPool` instead of a kernel thread. `get()` does not block on a condition variable, it
+ * suspends the fiber and control returns to the caller of `processInput`. Since the fiber only runs while the caller
+ * is inside `processInput`, there is no concurrency, and there is no need for a queue or a mutex: the fiber reads the
+ * inputs straight from the caller's span and suspends once it has consumed all of them.
+ *
+ * Inputs must be provided by one thread at a time. Destroying the lights interrupts the fiber, which unwinds its stack
+ * just like the worker thread of `ThreadLights`.
+ */
+class FiberLights final : public Lights {
+   public:
+    /// Create lights running on a stack from `pool` and run the fiber until it waits for the first input.
+    explicit FiberLights(StackPool& pool = StackPool::instance());
+
+    /// Interrupt the fiber and let it finish.
+    ~FiberLights() override;
+
+    FiberLights(FiberLights const&) = delete;
+    FiberLights(FiberLights&&) = delete;
+    FiberLights& operator=(FiberLights const&) = delete;
+    FiberLights& operator=(FiberLights&&) = delete;
+
+    /// Provide an input, the fiber processes it before this returns.
+    void processInput(uint32_t input) override;
+
+    /// Provide several inputs, the fiber processes all of them with a single switch before this returns.
+    void processInputs(std::span<uint32_t const> inputs) override;
+
+    [[nodiscard]] LightsState save() const override {
+        return {tableRef(), getLights()};
+    }
+
+    /// Restore, the fiber abandons INIT before this returns.
+    void restore(LightsState const& state) override;
+
+   private:
+    class Interrupted {};
+    /// thrown by `get` to abandon INIT when the lights are restored
+    class Restored {};
+
+    void run();
+    /// run INIT, unless the lights are restored
+    void init();
+    uint32_t get();
+
+    /// inputs provided by the caller of `processInputs` which are not processed yet
+    std::span<uint32_t const> m_inputs;
+    /// set to make `get` throw `Interrupted`
+    bool m_interrupt{false};
+    /// set to make `get` throw `Restored`
+    bool m_restore{false};
+    /// the fiber executing `run`, declared last so that it starts after all other members are initialized
+    Fiber m_fiber;
+};
+
+#endif  // FIBERLIGHTS_HPP
@@ -0,0 +1,52 @@
+#ifndef FRAMEALLOCATION_HPP
+#define FRAMEALLOCATION_HPP
+
+#include <cstddef>
+#include <memory_resource>
+#include <new>
+
+#include "FramePool.hpp"
+
+/**
+ * Base of promise types whose co-routine frames are allocated from a `std::pmr::memory_resource`.
+ *
+ * Member functions taking the resource as their only argument, `R Owner::run(std::pmr::memory_resource*)`, allocate
+ * their frame from that resource. All other co-routines allocate from `FramePool::instance()`. The resource is stored
+ * in a header in front of the frame, so that `operator delete` can find it.
+ *
+ * Frames are always freed by the usual `operator delete`, as required for co-routines. GCC does not know that and
+ * reports `-Wmismatched-new-delete` for co-routines using the placement form; they suppress it locally.
+ */
+struct FrameAllocation {
+    /// Allocate the co-routine frame from the memory resource passed to the member function `run`.
+    template <typename Owner>
+    static void* operator new(size_t size, Owner& /*self*/, std::pmr::memory_resource* resource) {
+        return allocate(size, resource);
+    }
+
+    /// Allocate the co-routine frame from the frame pool.
+    static void* operator new(size_t size) {
+        return allocate(size, &FramePool::instance());
+    }
+
+    /// Return the co-routine frame to the memory resource it was allocated from.
+    static void operator delete(void* frame, size_t size) noexcept {
+        auto* block = static_cast<std::byte*>(frame) - FRAME_HEADER;  // NOLINT(*-pro-bounds-pointer-arithmetic)
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast): header written by allocate
+        auto* resource = *std::launder(reinterpret_cast<std::pmr::memory_resource**>(block));
+        resource->deallocate(block, size + FRAME_HEADER, FRAME_HEADER);
+    }
+
+   private:
+    /// size of the header in front of the frame, keeps the frame aligned
+    static constexpr size_t FRAME_HEADER = __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+
+    /// allocate a frame of `size` bytes and its header from `resource`
+    static void* allocate(size_t size, std::pmr::memory_resource* resource) {
+        auto* block = static_cast<std::byte*>(resource->allocate(size + FRAME_HEADER, FRAME_HEADER));
+        new (block) std::pmr::memory_resource*{resource};
+        return block + FRAME_HEADER;  // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    }
+};
+
+#endif  // FRAMEALLOCATION_HPP
@@ -0,0 +1,86 @@
+#include "FramePool.hpp"
+
+#include <cstddef>
+#include <memory_resource>
+#include <mutex>
+
+namespace {
+/// the global heap
+std::pmr::memory_resource* upstream() {
+    return std::pmr::new_delete_resource();
+}
+}  // namespace
+
+FramePool::~FramePool() {
+    for (auto* chunk : m_chunks) {
+        upstream()->deallocate(chunk, CHUNK_SIZE, GRANULARITY);
+    }
+}
+
+FramePool& FramePool::instance() {
+    // intentionally leaked, objects with static storage duration may still return blocks during shutdown
+    static auto* pool = new FramePool{};  // NOLINT(cppcoreguidelines-owning-memory)
+    return *pool;
+}
+
+FramePool::Stats FramePool::stats() const {
+    std::lock_guard<SpinLock> const lock{m_lock};
+    return m_stats;
+}
+
+void* FramePool::do_allocate(size_t bytes, size_t alignment) {
+    std::lock_guard<SpinLock> const lock{m_lock};
+    ++m_stats.allocations;
+
+    if (bytes > MAX_BLOCK || alignment > GRANULARITY) {
+        ++m_stats.upstreamAllocations;
+        m_stats.upstreamBytes += bytes;
+        m_stats.bytesInUse += bytes;
+        return upstream()->allocate(bytes, alignment);
+    }
+
+    auto const sizeClass = bytes == 0 ? 0 : (bytes - 1) / GRANULARITY;
+    m_stats.bytesInUse += (sizeClass + 1) * GRANULARITY;
+    if (m_free.at(sizeClass) == nullptr) {
+        refill(sizeClass);
+    }
+    auto* block = m_free.at(sizeClass);
+    m_free.at(sizeClass) = block->next;
+    return block;
+}
+
+void FramePool::do_deallocate(void* pointer, size_t bytes, size_t alignment) {
+    std::lock_guard<SpinLock> const lock{m_lock};
+    ++m_stats.deallocations;
+
+    if (bytes > MAX_BLOCK || alignment > GRANULARITY) {
+        m_stats.bytesInUse -= bytes;
+        upstream()->deallocate(pointer, bytes, alignment);
+        return;
+    }
+
+    auto const sizeClass = bytes == 0 ? 0 : (bytes - 1) / GRANULARITY;
+    m_stats.bytesInUse -= (sizeClass + 1) * GRANULARITY;
+    auto* block = static_cast<Block*>(pointer);
+    block->next = m_free.at(sizeClass);
+    m_free.at(sizeClass) = block;
+}
+
+bool FramePool::do_is_equal(std::pmr::memory_resource const& other) const noexcept {
+    return this == &other;
+}
+
+void FramePool::refill(size_t sizeClass) {
+    auto* chunk = static_cast<std::byte*>(upstream()->allocate(CHUNK_SIZE, GRANULARITY));
+    m_chunks.push_back(chunk);
+    ++m_stats.upstreamAllocations;
+    m_stats.upstreamBytes += CHUNK_SIZE;
+
+    // NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic): blocks are carved from a raw chunk
+    auto const blockSize = (sizeClass + 1) * GRANULARITY;
+    for (size_t offset = 0; offset + blockSize <= CHUNK_SIZE; offset += blockSize) {
+        auto* block = new (chunk + offset) Block{m_free.at(sizeClass)};
+        m_free.at(sizeClass) = block;
+    }
+    // NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+}
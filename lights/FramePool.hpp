@@ -0,0 +1,87 @@
+#ifndef FRAMEPOOL_HPP
+#define FRAMEPOOL_HPP
+
+#include <array>
+#include <cstddef>
+#include <memory_resource>
+#include <vector>
+
+#include "SpinLock.hpp"
+
+/**
+ * Size-class pool allocator for co-routine frames and other small, short-lived blocks.
+ *
+ * Requests are rounded up to a multiple of `GRANULARITY` and served from a free list per size class. Empty free lists
+ * are refilled with blocks carved from chunks obtained from the global heap. Blocks are returned to their free list on
+ * deallocation and are never given back to the global heap before the pool is destroyed, so once the pool has warmed
+ * up, creating and destroying objects does not touch the global heap any more. Requests larger than `MAX_BLOCK` or
+ * with an alignment stricter than `GRANULARITY` are forwarded to the global heap.
+ *
+ * The pool is a `std::pmr::memory_resource`, so it can also serve standard containers. It is thread-safe.
+ */
+class FramePool final : public std::pmr::memory_resource {
+   public:
+    /// Size classes are multiples of this, which is also the alignment of all blocks.
+    static constexpr size_t GRANULARITY = 64;
+    /// Largest block served from a free list.
+    static constexpr size_t MAX_BLOCK = 4096;
+    /// Size of chunks obtained from the global heap.
+    static constexpr size_t CHUNK_SIZE = 64 * 1024;
+
+    /// Allocation counters.
+    struct Stats {
+        /// number of allocations served
+        size_t allocations;
+        /// number of deallocations served
+        size_t deallocations;
+        /// number of allocations forwarded to the global heap (chunks and large blocks)
+        size_t upstreamAllocations;
+        /// number of bytes obtained from the global heap
+        size_t upstreamBytes;
+        /// number of bytes currently allocated, rounded up to size classes
+        size_t bytesInUse;
+    };
+
+    FramePool() = default;
+
+    /// Release all chunks to the global heap. All blocks must have been deallocated.
+    ~FramePool() override;
+
+    FramePool(FramePool const&) = delete;
+    FramePool(FramePool&&) = delete;
+    FramePool& operator=(FramePool const&) = delete;
+    FramePool& operator=(FramePool&&) = delete;
+
+    /// Process-wide pool. It is never destroyed, so it outlives every object allocating from it.
+    static FramePool& instance();
+
+    /// Snapshot of the allocation counters.
+    [[nodiscard]] Stats stats() const;
+
+   private:
+    /// free block, the link is stored in the block itself
+    struct Block {
+        Block* next;
+    };
+
+    /// number of size classes
+    static constexpr size_t CLASSES = MAX_BLOCK / GRANULARITY;
+
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void* pointer, size_t bytes, size_t alignment) override;
+    [[nodiscard]] bool do_is_equal(std::pmr::memory_resource const& other) const noexcept override;
+
+    /// carve a new chunk into blocks of the given size class, lock must be held
+    void refill(size_t sizeClass);
+
+    /// protects all members below
+    mutable SpinLock m_lock;
+    /// free list per size class
+    std::array<Block*, CLASSES> m_free{};
+    /// chunks obtained from the global heap
+    std::vector<void*> m_chunks;
+    /// allocation counters
+    Stats m_stats{};
+};
+
+#endif  // FRAMEPOOL_HPP
@@ -0,0 +1,34 @@
+#ifndef FRAMETASK_HPP
+#define FRAMETASK_HPP
+
+#include <coroutine>
+
+#include "FrameAllocation.hpp"
+
+/**
+ * Return object of co-routines that start eagerly and are never awaited, like the `run` co-routine of `TimedLights`.
+ *
+ * The co-routine runs until its owner destroys it through the handle kept by its awaitable, or until it returns. The
+ * frame is allocated as described for `FrameAllocation`. Use `Task` for co-routines that are awaited or owned.
+ */
+struct FrameTask {
+    struct promise_type : FrameAllocation {
+        static FrameTask get_return_object() noexcept {
+            return {};
+        }
+
+        static std::suspend_never initial_suspend() noexcept {
+            return {};
+        }
+
+        static std::suspend_never final_suspend() noexcept {
+            return {};
+        }
+
+        void return_void() noexcept {}
+
+        void unhandled_exception() noexcept {}
+    };
+};
+
+#endif  // FRAMETASK_HPP
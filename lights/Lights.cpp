@@ -0,0 +1,91 @@
+#include "Lights.hpp"
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <utility>
+
+#include "LightsChanges.hpp"
+#include "RingBufferSink.hpp"
+
+namespace {
+/// number of instances to prefetch ahead when reading the published lights of a fleet
+constexpr size_t PREFETCH = 8;
+
+/// the sink set by `setDefaultSink`
+std::atomic<TransitionSink*>& defaultSinkSlot() {
+    static std::atomic<TransitionSink*> slot{nullptr};
+    return slot;
+}
+
+/// true once `setDefaultSink` was called; until then new instances use the console sink, which is only created then
+std::atomic<bool>& defaultSinkSet() {
+    static std::atomic<bool> set{false};
+    return set;
+}
+}  // namespace
+
+TransitionSink* Lights::defaultSink() {
+#ifndef LIGHTS_NO_SINK
+    if (!defaultSinkSet().load(std::memory_order_acquire)) {
+        return &RingBufferSink::console();
+    }
+#endif
+    return defaultSinkSlot().load(std::memory_order_acquire);
+}
+
+void Lights::setDefaultSink(TransitionSink* sink) {
+    defaultSinkSlot().store(sink, std::memory_order_release);
+    defaultSinkSet().store(true, std::memory_order_release);
+}
+
+void Lights::checkRestore(LightsState const& state, bool initialized) {
+    if (state.table == nullptr) {
+        throw std::invalid_argument{"Cannot restore lights without a state table"};
+    }
+    if (initialized) {
+        throw std::logic_error{"Cannot restore lights past INIT"};
+    }
+}
+
+void Lights::replaceTable(StateTableRegistry::Ref table) {
+    if (table == nullptr) {
+        throw std::invalid_argument{"Cannot replace the state table by no table"};
+    }
+    auto* slot = m_slot.load(std::memory_order_acquire);
+    if (slot->current() == nullptr) {
+        throw std::logic_error{"Cannot replace the state table of lights without a replaceable table"};
+    }
+    slot->replace(std::move(table));
+}
+
+void Lights::share(std::shared_ptr<TableSlot> group, uint32_t lights) {
+    if (group == nullptr || group->current() == nullptr) {
+        throw std::invalid_argument{"Cannot share the table of a group without a table"};
+    }
+    restore({group->table(), lights});
+    m_group = std::move(group);
+    m_slot.store(m_group.get(), std::memory_order_release);
+    // from now on the table is read from the group, which keeps it alive for readers that loaded it from the own slot,
+    // so it need not be retired
+    m_ownTable.clear();
+}
+
+void Lights::publish(LightsChanges& changes, uint32_t from, uint32_t to) noexcept {
+    changes.publish(from, to);
+}
+
+void Lights::published(std::span<Lights const* const> fleet, std::span<PublishedLights> out) noexcept {
+    assert(out.size() >= fleet.size() && "Too few entries for the published lights of the fleet");
+    for (size_t i = 0; i < fleet.size(); ++i) {
+        // the instances are spread over the heap, fetch the next cache lines while the current one is read
+        if (i + PREFETCH < fleet.size()) {
+            __builtin_prefetch(&fleet[i + PREFETCH]->m_published);
+        }
+        out[i] = fleet[i]->published();
+    }
+}
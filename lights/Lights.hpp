@@ -1,21 +1,101 @@
 #ifndef LIGHTS_HPP
 #define LIGHTS_HPP
 
+#include <atomic>
+#include <chrono>
+#include <cstddef>
 #include <cstdint>
-#include <iostream>
+#include <ctime>
+#include <memory>
+#include <span>
+#include <thread>
+#include <utility>
+
+#include "LightsStats.hpp"
+#include "StateTable.hpp"
+#include "TableSlot.hpp"
+#include "TransitionSink.hpp"
+
+class LightsChanges;
+
+/// State of an instance in RUN: its state table and current lights. See `Lights::save` and `Lights::restore`.
+struct LightsState {
+    /// the states, `nullptr` if INIT is not complete
+    StateTableRegistry::Ref table;
+    /// the current lights
+    uint32_t lights;
+};
+
+/// Current lights of an instance as seen by another thread, see `Lights::published`.
+struct PublishedLights {
+    /// the current lights
+    uint32_t lights;
+    /// number of times the lights were set (transitions and restores), even if they did not change
+    uint64_t sequence;
+    /// when the lights were set last, with the resolution of a scheduler tick; the epoch if never set or if compiled
+    /// with `LIGHTS_NO_STATS`
+    std::chrono::steady_clock::time_point changedAt;
+};
 
 /**
  * Example abstract class to demonstrate awaiting co-routine
+ *
+ * Transitions and rejected inputs are reported as `TransitionEvent` to a `TransitionSink`. If the library is compiled
+ * with `LIGHTS_NO_SINK` defined, events are not recorded at all and there is no overhead.
+ *
+ * Every instance counts its inputs, transitions and rejected inputs (see `LightsStats.hpp`), the counts are also added
+ * to the process-wide `aggregateStats()`.
+ *
+ * Transitions can be awaited by a consumer, see `LightsChanges.hpp`. Other threads can poll the current lights with
+ * `published()`: the lights are published with a sequence lock, so readers never block the thread processing inputs.
+ *
+ * The state table of an instance in RUN can be replaced while inputs are processed (`replaceTable`), or shared with a
+ * group of instances whose table is replaced at once (`share`). Implementations read the table through a `TableSlot`,
+ * inside a `TableSlot::ReadGuard` per input or batch of inputs.
  */
 class Lights {
    public:
     virtual ~Lights() = default;
 
-    /// Get current lights.
+    /// Get current lights. Safe to call from any thread.
     [[nodiscard]] uint32_t getLights() const {
-        return m_lights;
+        return m_published.lights.load(std::memory_order_relaxed);
     }
 
+    /**
+     * Get current lights together with their sequence number and time of change. Safe to call from any thread.
+     *
+     * The three values are consistent: they were set by the same transition. Readers retry while a transition is being
+     * published, they never write to the instance and never delay the thread processing inputs.
+     */
+    [[nodiscard]] PublishedLights published() const noexcept {
+        for (int spins = 0;; ++spins) {
+            auto const sequence = m_published.sequence.load(std::memory_order_acquire);
+            if ((sequence & 1) == 0) {
+                auto const lights = m_published.lights.load(std::memory_order_relaxed);
+                auto const changedAt = m_published.changedAt.load(std::memory_order_relaxed);
+                // order the loads of the values before the second load of the sequence number
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (m_published.sequence.load(std::memory_order_relaxed) == sequence) {
+                    return {lights, sequence / 2, std::chrono::steady_clock::time_point{std::chrono::nanoseconds{
+                                                      static_cast<std::chrono::nanoseconds::rep>(changedAt)}}};
+                }
+            }
+            if (spins >= MAX_SPINS) {
+                // the writer might be preempted in the middle of a transition
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    /**
+     * Copy the published lights of every instance of `fleet` to `out`, in one pass. Safe to call from any thread.
+     *
+     * Each entry is consistent as described for `published()`, but the instances are read one after another, not at
+     * one instant. `out` must have at least as many entries as `fleet`.
+     */
+    static void published(std::span<Lights const* const> fleet, std::span<PublishedLights> out) noexcept;
+
     /**
      * Provide an input to be processed.
      *
@@ -29,16 +109,305 @@ class Lights {
      */
     virtual void processInput(uint32_t input) = 0;
 
+    /**
+     * Provide several inputs to be processed in order.
+     *
+     * This is equivalent to calling `processInput` for each input, but implementations override it to consume the whole
+     * span at once and avoid per-input overhead.
+     */
+    virtual void processInputs(std::span<uint32_t const> inputs) {
+        for (auto input : inputs) {
+            processInput(input);
+        }
+    }
+
+    /**
+     * Capture the state of the instance, e.g. to write a snapshot (see `Snapshot.hpp`).
+     *
+     * The table is `nullptr` while INIT is not complete. Must not be called while inputs are being processed.
+     */
+    [[nodiscard]] virtual LightsState save() const = 0;
+
+    /**
+     * Put the instance into RUN with the states of `state.table` and the lights `state.lights`, without going through
+     * INIT and without recording a transition.
+     *
+     * Must be called before any input is provided. Throws `std::invalid_argument` if the state has no table, and
+     * `std::logic_error` if the instance is past INIT already.
+     */
+    virtual void restore(LightsState const& state) = 0;
+
+    /**
+     * Replace the state table while inputs are processed, e.g. to switch to a new timing plan.
+     *
+     * Inputs processed from now on select states of `table`, a batch of inputs provided at once is processed with one
+     * table. The lights do not change until the next transition. If the instance shares the table of a group, the table
+     * of the whole group is replaced. The previous table is released once no input processed with it is in progress.
+     * Safe to call from any thread, never waits for the thread processing inputs.
+     *
+     * Throws `std::invalid_argument` if `table` is `nullptr`, and `std::logic_error` if the instance has no table to
+     * replace (INIT is not complete, or the table is fixed like the one of `StaticLights`).
+     */
+    void replaceTable(StateTableRegistry::Ref table);
+
+    /**
+     * Put the instance into RUN with the table of `group` and the lights `lights`, like `restore`, and let it use the
+     * table of the group from then on.
+     *
+     * Replacing the table of the group with `TableSlot::replace` switches all instances sharing it at once, e.g. to
+     * update the timing plan of a city. Must be called before any input is provided. Throws like `restore`, and
+     * `std::invalid_argument` if `group` is `nullptr` or has no table.
+     */
+    void share(std::shared_ptr<TableSlot> group, uint32_t lights);
+
+    /**
+     * Set the sink receiving the events of this instance, `nullptr` to not record any events.
+     *
+     * The `tag` is recorded with every event to identify the instance. Must be called before any input is provided.
+     */
+    void setSink(TransitionSink* sink, uint32_t tag = 0) noexcept {
+#ifndef LIGHTS_NO_SINK
+        m_sink = sink;
+        m_tag = tag;
+#else
+        static_cast<void>(sink);
+        static_cast<void>(tag);
+#endif
+    }
+
+    /// The sink receiving the events of this instance, `nullptr` if none or compiled with `LIGHTS_NO_SINK`.
+    [[nodiscard]] TransitionSink* sink() const noexcept {
+#ifndef LIGHTS_NO_SINK
+        return m_sink;
+#else
+        return nullptr;
+#endif
+    }
+
+    /// The tag recorded with the events of this instance.
+    [[nodiscard]] uint32_t tag() const noexcept {
+#ifndef LIGHTS_NO_SINK
+        return m_tag;
+#else
+        return 0;
+#endif
+    }
+
+    /// Snapshot of the counters of this instance, all zero if compiled with `LIGHTS_NO_STATS`.
+    [[nodiscard]] LightsCounters counters() const noexcept {
+#ifndef LIGHTS_NO_STATS
+        return m_counters.snapshot();
+#else
+        return {};
+#endif
+    }
+
+    /// Sink used by instances created from now on, initially `RingBufferSink::console()`, created on first use.
+    static TransitionSink* defaultSink();
+
+    /// Set the sink used by instances created from now on, `nullptr` to not record any events.
+    static void setDefaultSink(TransitionSink* sink);
+
    protected:
-    /// Set the current lights and print some debug message.
-    void setLights(uint32_t lights) {
-        std::cout << "Switching lights from " << m_lights << " to " << lights << "\n";
-        m_lights = lights;
+    /// Set the current lights without recording a transition, for `restore`.
+    void restoreLights(uint32_t lights) noexcept {
+        publishLights(lights, changeTime());
+    }
+
+    /// Check whether the instance has a table, i.e., INIT is complete or the instance was restored. Thread-safe.
+    [[nodiscard]] bool hasTable() const noexcept {
+        return m_slot.load(std::memory_order_acquire)->current() != nullptr;
+    }
+
+    /// The current table, only valid inside the `TableSlot::ReadGuard` it was obtained in. Must only be called in RUN.
+    [[nodiscard]] StateTable const& table() const noexcept {
+        return *m_slot.load(std::memory_order_acquire)->current();
+    }
+
+    /// Reference to the current table, for `save`.
+    [[nodiscard]] StateTableRegistry::Ref tableRef() const {
+        return m_slot.load(std::memory_order_acquire)->table();
+    }
+
+    /// Set the table at the end of INIT or by `restore`.
+    void initTable(StateTableRegistry::Ref table) {
+        m_ownTable.replace(std::move(table));
+    }
+
+    /// Throw unless `state` can be restored by an instance whose INIT is complete if `initialized` is true.
+    static void checkRestore(LightsState const& state, bool initialized);
+
+    /**
+     * Time of a transition for `setLights`, in nanoseconds on the steady clock.
+     *
+     * Read from the coarse clock, which has the resolution of a scheduler tick but costs a fraction of a precise
+     * reading. Loops setting the lights for a batch of inputs read it once per batch. Always `0` if compiled with
+     * `LIGHTS_NO_STATS`.
+     */
+    static uint64_t changeTime() noexcept {
+#ifndef LIGHTS_NO_STATS
+        timespec time{};
+        clock_gettime(CLOCK_MONOTONIC_COARSE, &time);
+        return static_cast<uint64_t>(time.tv_sec) * 1'000'000'000U + static_cast<uint64_t>(time.tv_nsec);
+#else
+        return 0;
+#endif
+    }
+
+    /// Set the current lights, changed at `changedAt` (see `changeTime`), and record a transition event.
+    void setLights(uint32_t lights, uint64_t changedAt = changeTime()) noexcept {
+        count(Counter::Transitions);
+        auto const from = m_published.lights.load(std::memory_order_relaxed);
+        record(TransitionEvent::Kind::Transition, from, lights);
+        publishLights(lights, changedAt);
+        if (auto* changes = m_changes.load(std::memory_order_acquire); changes != nullptr) {
+            publish(*changes, from, lights);
+        }
+    }
+
+    /// Record an event for an input rejected because there are only `len` states.
+    void reportOutOfBounds(uint32_t input, size_t len) const noexcept {
+        count(Counter::OutOfBounds);
+        record(TransitionEvent::Kind::OutOfBounds, input, static_cast<uint32_t>(len));
+    }
+
+    /// Record an event of given kind with the sink of this instance, if any.
+    void record(TransitionEvent::Kind kind, uint32_t first, uint32_t second) const noexcept {
+#ifndef LIGHTS_NO_SINK
+        if (m_sink != nullptr) {
+            m_sink->record({m_tag, kind, first, second});
+        }
+#else
+        static_cast<void>(kind);
+        static_cast<void>(first);
+        static_cast<void>(second);
+#endif
+    }
+
+    /**
+     * Scope timing a call of `processInput`, if it is sampled.
+     *
+     * Put a probe at the top of `processInput`. One call in `LATENCY_SAMPLING` per instance is timed, the latency is
+     * recorded in the histogram of the calling thread when the probe goes out of scope. Other calls only cost an
+     * increment.
+     */
+    class LatencyProbe {
+       public:
+        /// Calls between two timed calls, a power of two.
+        static constexpr uint32_t LATENCY_SAMPLING = 64;
+
+#ifndef LIGHTS_NO_STATS
+        explicit LatencyProbe(Lights const& lights) noexcept {
+            // racy increments by concurrent callers only skew the sampling
+            auto const calls = lights.m_calls.load(std::memory_order_relaxed) + 1;
+            lights.m_calls.store(calls, std::memory_order_relaxed);
+            if ((calls & (LATENCY_SAMPLING - 1)) == 0) {
+                m_start = std::chrono::steady_clock::now();
+            }
+        }
+
+        ~LatencyProbe() {
+            if (m_start != std::chrono::steady_clock::time_point{}) {
+                std::chrono::nanoseconds const elapsed = std::chrono::steady_clock::now() - m_start;
+                StatsShard::local().recordLatency(static_cast<uint64_t>(elapsed.count()));
+            }
+        }
+#else
+        explicit LatencyProbe(Lights const& /*lights*/) noexcept {}
+        ~LatencyProbe() = default;
+#endif
+
+        LatencyProbe(LatencyProbe const&) = delete;
+        LatencyProbe(LatencyProbe&&) = delete;
+        LatencyProbe& operator=(LatencyProbe const&) = delete;
+        LatencyProbe& operator=(LatencyProbe&&) = delete;
+
+#ifndef LIGHTS_NO_STATS
+       private:
+        /// start time of a timed call, the epoch for calls which are not timed
+        std::chrono::steady_clock::time_point m_start{};
+#endif
+    };
+
+    /// Add `n` to `counter` of this instance and of the calling thread. Must only be called by one thread at a time.
+    void count(Counter counter, uint64_t n = 1) const noexcept {
+#ifndef LIGHTS_NO_STATS
+        m_counters.add(counter, n);
+        StatsShard::local().counters.add(counter, n);
+#else
+        static_cast<void>(counter);
+        static_cast<void>(n);
+#endif
+    }
+
+    /// Add `n` to `counter`, safe to call concurrently from several threads. Use on slow paths only.
+    void countShared(Counter counter, uint64_t n = 1) const noexcept {
+#ifndef LIGHTS_NO_STATS
+        m_counters.addShared(counter, n);
+        StatsShard::local().counters.add(counter, n);
+#else
+        static_cast<void>(counter);
+        static_cast<void>(n);
+#endif
     }
 
    private:
-    /// The current lights, initialized to `0`.
-    uint32_t m_lights{0};
+    friend class LightsChanges;
+
+    /// Spins of `published()` before yielding while a transition is being published.
+    static constexpr int MAX_SPINS = 100;
+
+    /// Queue a transition with the stream watching this instance.
+    static void publish(LightsChanges& changes, uint32_t from, uint32_t to) noexcept;
+
+    /// Set the current lights for readers on other threads. Must only be called by one thread at a time.
+    void publishLights(uint32_t lights, uint64_t changedAt) noexcept {
+        // an odd sequence number tells readers to retry, the fence keeps the stores of the values behind it
+        auto const sequence = m_published.sequence.load(std::memory_order_relaxed);
+        m_published.sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        m_published.lights.store(lights, std::memory_order_relaxed);
+        m_published.changedAt.store(changedAt, std::memory_order_relaxed);
+        m_published.sequence.store(sequence + 2, std::memory_order_release);
+    }
+
+#ifndef LIGHTS_NO_SINK
+    /// The sink receiving the events, may be `nullptr`.
+    TransitionSink* m_sink{defaultSink()};
+    /// The tag recorded with every event.
+    uint32_t m_tag{};
+#endif
+
+#ifndef LIGHTS_NO_STATS
+    /// The counters of this instance, updated from `const` methods reporting events.
+    mutable CounterSet m_counters;
+    /// Calls of `processInput`, to select calls timed by `LatencyProbe`.
+    mutable std::atomic<uint32_t> m_calls{0};
+#endif
+
+    /// The table of this instance, empty if it shares the table of a group.
+    TableSlot m_ownTable;
+    /// The group whose table the instance shares, may be `nullptr`.
+    std::shared_ptr<TableSlot> m_group;
+    /// The slot the table is read from, `m_ownTable` or the slot of `m_group`.
+    std::atomic<TableSlot*> m_slot{&m_ownTable};
+
+    /// The stream watching the transitions of this instance, may be `nullptr`.
+    std::atomic<LightsChanges*> m_changes{nullptr};
+
+    /// Lights published by the sequence lock, on a cache line of their own so that readers polling them do not
+    /// contend with the counters updated for every input.
+    struct alignas(64) Published {
+        /// twice the number of times the lights were set, odd while they are being set
+        std::atomic<uint64_t> sequence{0};
+        /// the current lights, initialized to `0`
+        std::atomic<uint32_t> lights{0};
+        /// nanoseconds on the steady clock when the lights were set last
+        std::atomic<uint64_t> changedAt{0};
+    };
+
+    /// The current lights.
+    Published m_published;
 };
 
 #endif  // LIGHTS_HPP
@@ -0,0 +1,146 @@
+#include "LightsBank.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <stdexcept>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace {
+#if defined(__AVX2__)
+/// number of 32 bit lanes in an AVX2 register
+constexpr size_t LANES = 8;
+
+/// Lane-wise unsigned `lhs < rhs`, AVX2 only has a signed comparison.
+__m256i lessUnsigned(__m256i lhs, __m256i rhs) {
+    auto const bias = _mm256_set1_epi32(std::numeric_limits<int32_t>::min());
+    return _mm256_cmpgt_epi32(_mm256_xor_si256(rhs, bias), _mm256_xor_si256(lhs, bias));
+}
+#endif
+}  // namespace
+
+LightsBank::LightsBank(size_t maxStates) : m_stride{std::max<size_t>(maxStates, 1)} {}
+
+LightsBank::Id LightsBank::add(std::span<uint32_t const> states) {
+    if (states.size() > m_stride) {
+        throw std::length_error{"LightsBank: too many states"};
+    }
+    auto const id = static_cast<Id>(size());
+    m_tables.insert(m_tables.end(), states.begin(), states.end());
+    m_tables.resize(m_tables.size() + m_stride - states.size());
+    m_lens.push_back(static_cast<uint32_t>(states.size()));
+    m_states.push_back(NO_STATE);
+    m_lights.push_back(0);
+    return id;
+}
+
+// NOLINTBEGIN(cppcoreguidelines-pro-type-reinterpret-cast,cppcoreguidelines-pro-bounds-pointer-arithmetic): intrinsics
+void LightsBank::tick(std::span<uint32_t const> inputs) {
+    inputs = inputs.first(std::min(inputs.size(), size()));
+    size_t i = 0;
+
+#if defined(__AVX2__)
+    // gather indices are 32 bit
+    if (m_tables.size() <= static_cast<size_t>(std::numeric_limits<int32_t>::max())) {
+        auto const stride = _mm256_set1_epi32(static_cast<int32_t>(m_stride));
+        auto const lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+        auto const* tables = reinterpret_cast<int const*>(m_tables.data());
+        for (; i + LANES <= inputs.size(); i += LANES) {
+            auto const input = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(inputs.data() + i));
+            auto const len = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(m_lens.data() + i));
+            auto const valid = lessUnsigned(input, len);
+            auto const instance = _mm256_add_epi32(_mm256_set1_epi32(static_cast<int32_t>(i)), lane);
+            auto const index = _mm256_add_epi32(_mm256_mullo_epi32(instance, stride), input);
+
+            // masked gather: lanes with out of bounds inputs keep their lights and are never loaded
+            auto* lights = reinterpret_cast<__m256i*>(m_lights.data() + i);
+            auto* states = reinterpret_cast<__m256i*>(m_states.data() + i);
+            _mm256_storeu_si256(lights, _mm256_mask_i32gather_epi32(_mm256_loadu_si256(lights), tables, index, valid,
+                                                                    sizeof(uint32_t)));
+            _mm256_storeu_si256(states, _mm256_blendv_epi8(_mm256_loadu_si256(states), input, valid));
+        }
+    }
+#endif
+
+    tickScalar(i, inputs);
+}
+
+void LightsBank::apply(std::span<Event const> events) {
+    static_assert(sizeof(Event) == 2 * sizeof(uint32_t), "events must be packed pairs");
+    size_t i = 0;
+
+#if defined(__AVX2__)
+    if (m_tables.size() <= static_cast<size_t>(std::numeric_limits<int32_t>::max())) {
+        auto const stride = _mm256_set1_epi32(static_cast<int32_t>(m_stride));
+        auto const deinterleave = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+        auto const* tables = reinterpret_cast<int const*>(m_tables.data());
+        auto const* lens = reinterpret_cast<int const*>(m_lens.data());
+        alignas(32) std::array<uint32_t, LANES> instances{};
+        alignas(32) std::array<uint32_t, LANES> inputs{};
+        alignas(32) std::array<uint32_t, LANES> values{};
+        for (; i + LANES <= events.size(); i += LANES) {
+            // same precondition as `applyScalar`, the gathers below do not check the instances
+            assert(std::all_of(events.begin() + static_cast<std::ptrdiff_t>(i),
+                               events.begin() + static_cast<std::ptrdiff_t>(i + LANES),
+                               [this](Event const& event) { return event.instance < size(); }) &&
+                   "Event for unknown instance");
+            // split 8 (instance, input) pairs into a vector of instances and a vector of inputs
+            auto const* pairs = reinterpret_cast<__m256i const*>(events.data() + i);
+            auto const low = _mm256_permutevar8x32_epi32(_mm256_loadu_si256(pairs), deinterleave);
+            auto const high = _mm256_permutevar8x32_epi32(_mm256_loadu_si256(pairs + 1), deinterleave);
+            auto const instance = _mm256_permute2x128_si256(low, high, 0x20);
+            auto const input = _mm256_permute2x128_si256(low, high, 0x31);
+
+            auto const len = _mm256_i32gather_epi32(lens, instance, sizeof(uint32_t));
+            auto const valid = lessUnsigned(input, len);
+            auto const index = _mm256_add_epi32(_mm256_mullo_epi32(instance, stride), input);
+            auto const value =
+                _mm256_mask_i32gather_epi32(_mm256_setzero_si256(), tables, index, valid, sizeof(uint32_t));
+
+            // AVX2 has no scatter; store in order so that later events for the same instance win
+            _mm256_store_si256(reinterpret_cast<__m256i*>(instances.data()), instance);
+            _mm256_store_si256(reinterpret_cast<__m256i*>(inputs.data()), input);
+            _mm256_store_si256(reinterpret_cast<__m256i*>(values.data()), value);
+            auto const mask = static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(valid)));
+            for (size_t lane = 0; lane < LANES; ++lane) {
+                if ((mask & (1U << lane)) != 0) {
+                    m_lights[instances.at(lane)] = values.at(lane);
+                    m_states[instances.at(lane)] = inputs.at(lane);
+                }
+            }
+        }
+    }
+#endif
+
+    applyScalar(i, events);
+}
+// NOLINTEND(cppcoreguidelines-pro-type-reinterpret-cast,cppcoreguidelines-pro-bounds-pointer-arithmetic)
+
+void LightsBank::tickScalar(size_t begin, std::span<uint32_t const> inputs) {
+    for (size_t i = begin; i < inputs.size(); ++i) {
+        auto const input = inputs[i];
+        auto const valid = input < m_lens[i];
+        // branch-free: out of bounds inputs read slot 0 and keep the old values
+        auto const value = m_tables[(i * m_stride) + (valid ? input : 0)];
+        m_lights[i] = valid ? value : m_lights[i];
+        m_states[i] = valid ? input : m_states[i];
+    }
+}
+
+void LightsBank::applyScalar(size_t begin, std::span<Event const> events) {
+    for (size_t i = begin; i < events.size(); ++i) {
+        auto const [instance, input] = events[i];
+        assert(instance < size() && "Event for unknown instance");
+        if (input < m_lens[instance]) {
+            m_lights[instance] = m_tables[(instance * m_stride) + input];
+            m_states[instance] = input;
+        }
+    }
+}
@@ -0,0 +1,89 @@
+#ifndef LIGHTSBANK_HPP
+#define LIGHTSBANK_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+
+/**
+ * Container simulating many lights instances in a structure-of-arrays layout.
+ *
+ * Instead of one object per instance, the bank stores the state tables of all instances in one flattened array (each
+ * instance gets `maxStates` slots) and the table lengths, active states and current lights in contiguous arrays
+ * indexed by instance ID. Instances are added in RUN phase, i.e., with their complete state table. Inputs are applied
+ * in bulk: a gather loads the addressed table entries for a whole vector of inputs at once and a bounds mask keeps the
+ * lights of instances receiving out of bounds inputs unchanged, just like the other implementations.
+ *
+ * The vectorized paths use AVX2 if the library is compiled for a target supporting it (e.g. with `LIGHTS_NATIVE`),
+ * otherwise a branch-free scalar loop is used. No events are recorded, the bank is meant for bulk simulation.
+ */
+class LightsBank {
+   public:
+    /// ID to address instances in the bank.
+    using Id = uint32_t;
+
+    /// Input addressed to an instance.
+    struct Event {
+        Id instance;
+        uint32_t input;
+    };
+
+    /// Active state of instances which have not accepted any input yet.
+    static constexpr uint32_t NO_STATE = std::numeric_limits<uint32_t>::max();
+
+    /// Create an empty bank for instances with up to `maxStates` states.
+    explicit LightsBank(size_t maxStates);
+
+    /**
+     * Add an instance with given state table and return its ID.
+     *
+     * Throws `std::length_error` if the table has more than `maxStates` states.
+     */
+    Id add(std::span<uint32_t const> states);
+
+    /// Number of instances.
+    [[nodiscard]] size_t size() const noexcept {
+        return m_lights.size();
+    }
+
+    /// Current lights of given instance.
+    [[nodiscard]] uint32_t lights(Id id) const {
+        return m_lights[id];
+    }
+
+    /// Active state of given instance, `NO_STATE` if it has not accepted any input yet.
+    [[nodiscard]] uint32_t state(Id id) const {
+        return m_states[id];
+    }
+
+    /**
+     * Apply one input to every instance: `inputs[i]` is the input of instance `i`.
+     *
+     * Instances beyond `inputs.size()` are left unchanged.
+     */
+    void tick(std::span<uint32_t const> inputs);
+
+    /// Apply events in order. Several events may address the same instance, all must address instances below `size()`.
+    void apply(std::span<Event const> events);
+
+   private:
+    /// apply inputs to instances from `begin` on, without SIMD
+    void tickScalar(size_t begin, std::span<uint32_t const> inputs);
+    /// apply events from `begin` on, without SIMD
+    void applyScalar(size_t begin, std::span<Event const> events);
+
+    /// number of table slots per instance
+    size_t m_stride;
+    /// flattened state tables, `m_stride` slots per instance
+    std::vector<uint32_t> m_tables;
+    /// number of states per instance
+    std::vector<uint32_t> m_lens;
+    /// active state per instance
+    std::vector<uint32_t> m_states;
+    /// current lights per instance
+    std::vector<uint32_t> m_lights;
+};
+
+#endif  // LIGHTSBANK_HPP
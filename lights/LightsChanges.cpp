@@ -0,0 +1,26 @@
+#include "LightsChanges.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+
+LightsChanges::LightsChanges(Lights& lights, size_t capacity, Scheduler* scheduler)
+    : m_lights{lights}, m_storage(capacity == 0 ? 1 : capacity) {
+    m_channel.bind(m_storage, scheduler);
+    LightsChanges* expected = nullptr;
+    if (!m_lights.m_changes.compare_exchange_strong(expected, this, std::memory_order_release)) {
+        throw std::logic_error{"Lights are watched already"};
+    }
+}
+
+LightsChanges::~LightsChanges() {
+    m_lights.m_changes.store(nullptr, std::memory_order_release);
+}
+
+void LightsChanges::publish(uint32_t from, uint32_t to) noexcept {
+    auto const merge = [](LightsChange& newest, LightsChange change) { newest.to = change.to; };
+    if (!m_channel.sendOrMerge({from, to}, merge)) {
+        m_merged.fetch_add(1, std::memory_order_relaxed);
+    }
+}
@@ -0,0 +1,97 @@
+#ifndef LIGHTSCHANGES_HPP
+#define LIGHTSCHANGES_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "Channel.hpp"
+#include "Lights.hpp"
+#include "Scheduler.hpp"
+
+/// A transition of the lights of an instance, see `LightsChanges`.
+struct LightsChange {
+    /// lights before the transition
+    uint32_t from;
+    /// lights after the transition
+    uint32_t to;
+};
+
+/**
+ * Stream of the transitions of one lights instance, for consumers that react to changes instead of polling
+ * `Lights::getLights()`.
+ *
+ * While a `LightsChanges` exists, every transition of the watched instance is queued in a bounded `Channel`. Consumers
+ * receive the transitions in one of the styles of the channel:
+ *
+ * - `co_await changes` from a co-routine, which suspends until the next transition and resumes with it. Without a
+ *   scheduler, the co-routine is resumed inline by whoever caused the transition, before the lights return from
+ *   `processInput`; it must not provide inputs to the same instance then.
+ * - `next()` from a thread, which blocks until the next transition, e.g. while a `ThreadLights` worker switches.
+ * - `tryNext()`, which does not block.
+ *
+ * The lights never wait for a slow consumer. If the queue is full, a transition is merged into the newest queued one,
+ * so the consumer misses the intermediate lights but always sees a consistent chain (`from` of each change is `to` of
+ * the previous one) ending in the current lights.
+ *
+ * There must be a single consumer. The stream must be created before, and destroyed after, the instance transitions
+ * while it exists; an instance is watched by at most one stream at a time.
+ */
+class LightsChanges {
+   public:
+    /// Default number of transitions queued before they are merged.
+    static constexpr size_t DEFAULT_CAPACITY = 64;
+
+    /**
+     * Watch `lights`, queue up to `capacity` transitions and resume awaiting co-routines using `scheduler`, or inline
+     * if it is `nullptr`. Throws `std::logic_error` if `lights` is watched already.
+     */
+    explicit LightsChanges(Lights& lights, size_t capacity = DEFAULT_CAPACITY, Scheduler* scheduler = nullptr);
+
+    /// Stop watching. A co-routine still awaiting a transition is not destroyed, it is owned by whoever started it.
+    ~LightsChanges();
+
+    LightsChanges(LightsChanges const&) = delete;
+    LightsChanges(LightsChanges&&) = delete;
+    LightsChanges& operator=(LightsChanges const&) = delete;
+    LightsChanges& operator=(LightsChanges&&) = delete;
+
+    /// Receive the next transition from a co-routine.
+    Channel<LightsChange>::Receiver operator co_await() noexcept {
+        return m_channel.operator co_await();
+    }
+
+    /// Receive the next transition, block until there is one.
+    LightsChange next() noexcept {
+        return m_channel.receive();
+    }
+
+    /// Receive the next transition unless none is queued.
+    std::optional<LightsChange> tryNext() noexcept {
+        return m_channel.tryReceive();
+    }
+
+    /// Number of transitions merged into a queued one because the queue was full.
+    [[nodiscard]] uint64_t merged() const noexcept {
+        return m_merged.load(std::memory_order_relaxed);
+    }
+
+   private:
+    friend class Lights;
+
+    /// queue a transition, called by the watched lights
+    void publish(uint32_t from, uint32_t to) noexcept;
+
+    /// the watched lights
+    Lights& m_lights;
+    /// storage of the channel
+    std::vector<LightsChange> m_storage;
+    /// the queued transitions
+    Channel<LightsChange> m_channel;
+    /// number of merged transitions
+    std::atomic<uint64_t> m_merged{0};
+};
+
+#endif  // LIGHTSCHANGES_HPP
@@ -0,0 +1,89 @@
+#include "LightsExecutor.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+LightsExecutor::Id LightsExecutor::spawn() {
+    m_instances.push_back(std::make_unique<CoRoutineLights>(this));
+    return m_instances.size() - 1;
+}
+
+size_t LightsExecutor::runOnce(size_t maxResumes) {
+    // only resume what is ready now, co-routines scheduled while resuming are processed in the next batch
+    auto const end = m_next + std::min(maxResumes, pending());
+    auto const count = end - m_next;
+    while (m_next < end) {
+        // index access, the ready-queue may grow while resuming
+        m_ready[m_next++].resume();
+    }
+
+    if (m_next == m_ready.size()) {
+        // all consumed, re-use storage
+        m_ready.clear();
+        m_next = 0;
+    } else if (m_next > m_ready.size() / 2) {
+        // drop consumed entries to bound memory
+        m_ready.erase(m_ready.begin(), m_ready.begin() + static_cast<std::ptrdiff_t>(m_next));
+        m_next = 0;
+    }
+
+    return count;
+}
+
+void LightsExecutor::cancel(std::coroutine_handle<> handle) noexcept {
+    // replace rather than erase, `runOnce` may be iterating over the ready-queue
+    std::replace(m_ready.begin() + static_cast<std::ptrdiff_t>(m_next), m_ready.end(), handle,
+                 std::coroutine_handle<>{std::noop_coroutine()});
+}
+
+void LightsExecutor::run() {
+    while (runOnce() > 0) {
+    }
+}
+
+size_t LightsExecutor::advance(Duration elapsed) {
+    run();
+    return advanceTicks(elapsed <= Duration::zero() ? 0 : static_cast<uint64_t>(elapsed / m_tick));
+}
+
+void LightsExecutor::runFor(Duration duration) {
+    using Clock = std::chrono::steady_clock;
+    auto const start = Clock::now();
+    auto const first = m_timers.now();
+    auto const last = first + static_cast<uint64_t>(std::max(duration, Duration::zero()) / m_tick);
+    while (true) {
+        run();
+        auto const elapsed = static_cast<uint64_t>(std::chrono::duration_cast<Duration>(Clock::now() - start) / m_tick);
+        auto const due = std::min(last, first + elapsed);
+        if (due > m_timers.now()) {
+            // catch up with the steady clock, possibly several ticks at once if the loop was late
+            advanceTicks(due - m_timers.now());
+        } else if (m_timers.now() == last) {
+            break;
+        } else {
+            std::this_thread::sleep_until(start + m_tick * (m_timers.now() - first + 1));
+        }
+    }
+}
+
+size_t LightsExecutor::advanceTicks(uint64_t ticks) {
+    size_t expired = 0;
+    for (uint64_t i = 0; i < ticks; ++i) {
+        if (m_timers.size() == 0) {
+            // nothing can become ready, skip the remaining ticks at once
+            m_timers.advance(ticks - i);
+            break;
+        }
+        auto const count = m_timers.tick();
+        if (count > 0) {
+            expired += count;
+            run();
+        }
+    }
+    return expired;
+}
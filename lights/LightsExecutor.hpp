@@ -0,0 +1,150 @@
+#ifndef LIGHTSEXECUTOR_HPP
+#define LIGHTSEXECUTOR_HPP
+
+#include <chrono>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "CoRoutineLights.hpp"
+#include "Scheduler.hpp"
+#include "TimingWheel.hpp"
+
+/**
+ * Single-threaded event loop driving many co-routine lights instances.
+ *
+ * The executor owns the instances, which are addressed by their ID. Inputs posted to an instance are queued in the
+ * instance, and the instance's co-routine is put on the executor's ready-queue. The co-routines are resumed in batches
+ * by `runOnce` (or `run`) from the loop's thread, so the stack of the caller posting inputs is never used to run the
+ * lights logic.
+ *
+ * The executor also keeps time in ticks of a fixed duration. Timers are scheduled on a `TimingWheel`; `advance` moves
+ * the clock forward by a given duration without waiting (simulated time), `runFor` follows the steady clock. In both
+ * cases, the timers expiring at a tick are fired and the co-routines they make ready are resumed before the next tick,
+ * so that timers scheduled by these co-routines are relative to the tick they were woken at. See `TimedLights`.
+ *
+ * This type is not thread-safe. All calls must be made from the thread running the loop.
+ */
+class LightsExecutor final : public Scheduler {
+   public:
+    /// ID to address instances owned by the executor.
+    using Id = size_t;
+
+    /// Resolution of the executor's clock.
+    using Duration = std::chrono::nanoseconds;
+
+    /// Default tick length.
+    static constexpr Duration DEFAULT_TICK = std::chrono::milliseconds{1};
+
+    /// Constructor, time advances in ticks of length `tick`, which must be positive.
+    explicit LightsExecutor(Duration tick = DEFAULT_TICK) noexcept : m_tick{tick} {}
+
+    /// Destroy all instances. Co-routines still on the ready-queue are not resumed.
+    ~LightsExecutor() override = default;
+
+    LightsExecutor(LightsExecutor const&) = delete;
+    LightsExecutor(LightsExecutor&&) = delete;
+    LightsExecutor& operator=(LightsExecutor const&) = delete;
+    LightsExecutor& operator=(LightsExecutor&&) = delete;
+
+    /// Create a new instance driven by this executor and return its ID.
+    Id spawn();
+
+    /// Number of instances owned by this executor.
+    [[nodiscard]] size_t size() const noexcept {
+        return m_instances.size();
+    }
+
+    /// Access the instance with given ID.
+    [[nodiscard]] CoRoutineLights& operator[](Id id) const {
+        return *m_instances[id];
+    }
+
+    /// Queue an input for the instance with given ID. The input is processed by the next call to `runOnce` or `run`.
+    void post(Id id, uint32_t input) {
+        m_instances[id]->processInput(input);
+    }
+
+    /// Queue several inputs for the instance with given ID, they are consumed by a single resume.
+    void post(Id id, std::span<uint32_t const> inputs) {
+        m_instances[id]->processInputs(inputs);
+    }
+
+    /**
+     * Resume up to `maxResumes` co-routines from the ready-queue.
+     *
+     * Co-routines that become ready while the batch is processed are appended to the ready-queue. Return the number
+     * of co-routines resumed.
+     */
+    size_t runOnce(size_t maxResumes = std::numeric_limits<size_t>::max());
+
+    /// Resume co-routines until the ready-queue is empty.
+    void run();
+
+    /// Number of co-routines waiting to be resumed.
+    [[nodiscard]] size_t pending() const noexcept {
+        return m_ready.size() - m_next;
+    }
+
+    /// Put a suspended co-routine on the ready-queue.
+    void schedule(std::coroutine_handle<> handle) override {
+        m_ready.push_back(handle);
+    }
+
+    /**
+     * Remove a co-routine from the ready-queue, e.g. because its frame is about to be destroyed. May be called while
+     * the ready-queue is run, the co-routine is not resumed then.
+     */
+    void cancel(std::coroutine_handle<> handle) noexcept;
+
+    /// Length of a tick.
+    [[nodiscard]] Duration tick() const noexcept {
+        return m_tick;
+    }
+
+    /// Time elapsed since the executor was created, as advanced by `advance` and `runFor`.
+    [[nodiscard]] Duration now() const noexcept {
+        return m_tick * m_timers.now();
+    }
+
+    /// Number of ticks to wait at least `duration`, rounded up.
+    [[nodiscard]] uint64_t ticks(Duration duration) const noexcept {
+        return duration <= Duration::zero() ? 0 : static_cast<uint64_t>((duration + m_tick - Duration{1}) / m_tick);
+    }
+
+    /// Timers driven by this executor.
+    [[nodiscard]] TimingWheel& timers() noexcept {
+        return m_timers;
+    }
+
+    /**
+     * Advance the clock by `elapsed`, rounded down to whole ticks, without waiting.
+     *
+     * The ready-queue is run first and after every tick at which timers expired. Return the number of expired timers.
+     */
+    size_t advance(Duration elapsed);
+
+    /// Run the loop for `duration` of steady clock time, sleeping while there is nothing to do until the next tick.
+    void runFor(Duration duration);
+
+   private:
+    /// advance by `ticks` ticks, running the ready-queue after every tick at which timers expired
+    size_t advanceTicks(uint64_t ticks);
+
+    /// length of a tick
+    Duration m_tick;
+    /// timers expiring at future ticks
+    TimingWheel m_timers;
+    /// owned instances, indexed by ID
+    std::vector<std::unique_ptr<CoRoutineLights>> m_instances;
+    /// ready-queue, declared after instances so that it is destroyed before the co-routine frames
+    std::vector<std::coroutine_handle<>> m_ready;
+    /// index of next co-routine to resume in the ready-queue
+    size_t m_next{};
+};
+
+#endif  // LIGHTSEXECUTOR_HPP
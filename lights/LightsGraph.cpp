@@ -0,0 +1,134 @@
+#include "LightsGraph.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <stdexcept>
+#include <utility>
+
+LightsGraph::Node LightsGraph::Builder::add(Lights& lights) {
+    m_nodes.push_back(&lights);
+    return static_cast<Node>(m_nodes.size() - 1);
+}
+
+LightsGraph::Builder& LightsGraph::Builder::connect(Node from, Node to, Map map) {
+    m_edges.push_back({from, to, map});
+    return *this;
+}
+
+LightsGraph::LightsGraph(Builder const& builder, size_t capacity, TransitionSink* downstream)
+    : m_nodes{builder.m_nodes},
+      m_outgoing(builder.m_nodes.size() + 1),
+      m_edgeCount{builder.m_edges.size()},
+      m_downstream{downstream} {
+#ifdef LIGHTS_NO_SINK
+    if (m_edgeCount > 0) {
+        throw std::logic_error{"LightsGraph: transitions are not recorded with LIGHTS_NO_SINK"};
+    }
+#endif
+    capacity = std::max<size_t>(capacity, 1);
+
+    // counting sort of the edges by source node
+    for (auto const& edge : builder.m_edges) {
+        if (edge.from >= m_nodes.size() || edge.to >= m_nodes.size()) {
+            throw std::out_of_range{"LightsGraph: edge refers to unknown node"};
+        }
+        ++m_outgoing[edge.from + 1];
+    }
+    for (size_t node = 0; node < m_nodes.size(); ++node) {
+        m_outgoing[node + 1] += m_outgoing[node];
+    }
+
+    m_links = std::make_unique<Link[]>(m_edgeCount);  // NOLINT(*-avoid-c-arrays)
+    m_storage = std::make_unique<uint32_t[]>(m_edgeCount * capacity);  // NOLINT(*-avoid-c-arrays)
+    std::vector<size_t> next{m_outgoing.begin(), m_outgoing.end() - 1};
+    for (auto const& edge : builder.m_edges) {
+        auto const index = next[edge.from]++;
+        auto& link = m_links[index];
+        link.channel.bind(std::span<uint32_t>{m_storage.get() + (index * capacity), capacity});
+        link.target = m_nodes[edge.to];
+        link.map = edge.map;
+    }
+
+    m_ready.reserve(m_edgeCount);
+    m_round.reserve(m_edgeCount);
+
+    m_detached.reserve(m_nodes.size());
+    for (size_t node = 0; node < m_nodes.size(); ++node) {
+        m_detached.push_back({m_nodes[node]->sink(), m_nodes[node]->tag()});
+        m_nodes[node]->setSink(this, static_cast<uint32_t>(node));
+    }
+}
+
+LightsGraph::~LightsGraph() {
+    // in reverse, so that an instance added as several nodes gets back the sink it had before the first one
+    for (auto node = m_nodes.size(); node-- > 0;) {
+        m_nodes[node]->setSink(m_detached[node].sink, m_detached[node].tag);
+    }
+}
+
+size_t LightsGraph::run(size_t maxValues) {
+    size_t delivered = 0;
+    while (delivered < maxValues) {
+        {
+            std::lock_guard<SpinLock> const lock{m_lock};
+            std::swap(m_ready, m_round);
+        }
+        if (m_round.empty()) {
+            break;
+        }
+        size_t i = 0;
+        for (; i < m_round.size() && delivered < maxValues; ++i) {
+            auto const index = m_round[i];
+            auto& link = m_links[index];
+            // clear the flag first: values sent from now on mark the edge ready again
+            link.ready.store(false, std::memory_order_release);
+            // the values stay in the channel storage while the target consumes them
+            auto const values = link.channel.peek();
+            auto const count = std::min(values.size(), maxValues - delivered);
+            if (count > 0) {
+                link.target->processInputs(values.first(count));
+                link.channel.consume(count);
+                delivered += count;
+            }
+            // values wrapped around the end of the storage or the limit was hit, continue in the next round
+            if (!link.channel.empty()) {
+                markReady(index);
+            }
+        }
+        if (i < m_round.size()) {
+            // limit hit, keep the remaining edges for the next call; they are still flagged ready
+            std::lock_guard<SpinLock> const lock{m_lock};
+            m_ready.insert(m_ready.end(), m_round.begin() + static_cast<std::ptrdiff_t>(i), m_round.end());
+        }
+        m_round.clear();
+    }
+    return delivered;
+}
+
+void LightsGraph::record(TransitionEvent const& event) noexcept {
+    if (m_downstream != nullptr) {
+        m_downstream->record(event);
+    }
+    if (event.kind != TransitionEvent::Kind::Transition) {
+        return;
+    }
+    for (auto index = m_outgoing[event.tag]; index < m_outgoing[event.tag + 1]; ++index) {
+        auto& link = m_links[index];
+        if (!link.channel.trySend(link.map(event.second))) {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        markReady(index);
+    }
+}
+
+void LightsGraph::markReady(size_t index) noexcept {
+    if (!m_links[index].ready.exchange(true, std::memory_order_acq_rel)) {
+        std::lock_guard<SpinLock> const lock{m_lock};
+        m_ready.push_back(index);
+    }
+}
@@ -0,0 +1,174 @@
+#ifndef LIGHTSGRAPH_HPP
+#define LIGHTSGRAPH_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "Channel.hpp"
+#include "Lights.hpp"
+#include "SpinLock.hpp"
+#include "TransitionSink.hpp"
+
+/**
+ * Network of lights instances, where the lights of one instance are inputs to other instances.
+ *
+ * The topology is described with a `Builder`: nodes are existing lights instances, edges connect the output of one
+ * node to the input of another one, optionally translating the lights value into an input with a `Map` function. The
+ * graph installs itself as the sink of every node. Whenever a node switches its lights, the (mapped) value is sent to a
+ * `Channel` per outgoing edge and the edge is marked ready. `run` then delivers the values of ready edges to their
+ * target nodes, which may switch their lights in turn, until no more values are pending.
+ *
+ * All channels share one storage arena allocated when the graph is built, so propagating values never allocates. The
+ * values are handed to `processInputs` straight from the channel storage, without copying them. If a channel is full,
+ * the value is dropped and counted.
+ *
+ * `run` is meant to be called from a single driver thread. Nodes may still switch from other threads (e.g.
+ * `ThreadLights`), the values they send are picked up by the next call to `run`. Without a sink (`LIGHTS_NO_SINK`),
+ * transitions cannot be observed, so graphs with edges cannot be built.
+ */
+class LightsGraph final : public TransitionSink {
+   public:
+    /// ID of a node.
+    using Node = uint32_t;
+
+    /// Function translating the lights of a source node into an input for a target node.
+    using Map = uint32_t (*)(uint32_t lights);
+
+    /// Map passing the lights on unchanged.
+    static uint32_t identity(uint32_t lights) noexcept {
+        return lights;
+    }
+
+    /// Default number of values each edge's channel can hold.
+    static constexpr size_t DEFAULT_CAPACITY = 16;
+
+    /// Description of the topology of a graph.
+    class Builder {
+       public:
+        /// Add a node for `lights` and return its ID. The instance must outlive the graph.
+        Node add(Lights& lights);
+
+        /// Connect the output of node `from` to the input of node `to`, translating values with `map`.
+        Builder& connect(Node from, Node to, Map map = identity);
+
+       private:
+        friend class LightsGraph;
+
+        /// edge between two nodes
+        struct Edge {
+            Node from;
+            Node to;
+            Map map;
+        };
+
+        /// the nodes
+        std::vector<Lights*> m_nodes;
+        /// the edges, in order of insertion
+        std::vector<Edge> m_edges;
+    };
+
+    /**
+     * Create the graph described by `builder`, with room for `capacity` values per edge.
+     *
+     * All events of the nodes are forwarded to `downstream`, if given. The graph must be created before any inputs are
+     * provided to the nodes. Throws `std::out_of_range` if an edge refers to an unknown node.
+     */
+    explicit LightsGraph(Builder const& builder, size_t capacity = DEFAULT_CAPACITY,
+                         TransitionSink* downstream = nullptr);
+
+    /// Detach from the nodes, which switch back to the sinks and tags they had when the graph was built.
+    ~LightsGraph() override;
+
+    LightsGraph(LightsGraph const&) = delete;
+    LightsGraph(LightsGraph&&) = delete;
+    LightsGraph& operator=(LightsGraph const&) = delete;
+    LightsGraph& operator=(LightsGraph&&) = delete;
+
+    /// Number of nodes.
+    [[nodiscard]] size_t nodes() const noexcept {
+        return m_nodes.size();
+    }
+
+    /// Number of edges.
+    [[nodiscard]] size_t edges() const noexcept {
+        return m_edgeCount;
+    }
+
+    /// Provide an input to a node from outside the graph.
+    void post(Node node, uint32_t input) {
+        m_nodes.at(node)->processInput(input);
+    }
+
+    /// Provide several inputs to a node from outside the graph.
+    void post(Node node, std::span<uint32_t const> inputs) {
+        m_nodes.at(node)->processInputs(inputs);
+    }
+
+    /**
+     * Deliver pending values along the edges until there are none left, or at least `maxValues` were delivered.
+     *
+     * Return the number of values delivered. With cycles in the graph, values may circulate forever, so a limit is
+     * required.
+     */
+    size_t run(size_t maxValues = std::numeric_limits<size_t>::max());
+
+    /// Number of values dropped because a channel was full.
+    [[nodiscard]] size_t dropped() const noexcept {
+        return m_dropped.load(std::memory_order_relaxed);
+    }
+
+    /// Send transitions of the node identified by the event's tag along its outgoing edges.
+    void record(TransitionEvent const& event) noexcept override;
+
+   private:
+    /// edge with its channel
+    struct Link {
+        /// values sent along the edge
+        Channel<uint32_t> channel;
+        /// true while the edge is in the ready list
+        std::atomic<bool> ready{false};
+        /// the target node
+        Lights* target{};
+        /// translation of lights into inputs
+        Map map{identity};
+    };
+
+    /// add edge `index` to the ready list unless it is already there
+    void markReady(size_t index) noexcept;
+
+    /// sink and tag of a node before it was wired into the graph
+    struct Detached {
+        TransitionSink* sink;
+        uint32_t tag;
+    };
+
+    /// the nodes
+    std::vector<Lights*> m_nodes;
+    /// sinks and tags of the nodes before they were wired, by node
+    std::vector<Detached> m_detached;
+    /// outgoing edges of node `n` are `m_links[m_outgoing[n]]` to `m_links[m_outgoing[n + 1] - 1]`
+    std::vector<size_t> m_outgoing;
+    /// the edges, grouped by source node
+    std::unique_ptr<Link[]> m_links;  // NOLINT(*-avoid-c-arrays)
+    /// number of edges
+    size_t m_edgeCount{};
+    /// storage shared by all channels
+    std::unique_ptr<uint32_t[]> m_storage;  // NOLINT(*-avoid-c-arrays)
+    /// receives all events of the nodes, may be `nullptr`
+    TransitionSink* m_downstream;
+    /// protects `m_ready`, nodes may switch from any thread
+    SpinLock m_lock;
+    /// indices of edges with pending values, each edge is listed at most once, so the reserved capacity suffices
+    std::vector<size_t> m_ready;
+    /// edges processed by the current round of `run`, only used by the driver
+    std::vector<size_t> m_round;
+    /// number of dropped values
+    std::atomic<size_t> m_dropped{0};
+};
+
+#endif  // LIGHTSGRAPH_HPP
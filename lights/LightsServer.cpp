@@ -0,0 +1,174 @@
+#include "LightsServer.hpp"
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <utility>
+
+#include "Reactor.hpp"
+#include "Task.hpp"
+
+namespace {
+/// throw the error indicated by `errno` for `what`, after closing `fd`
+[[noreturn]] void throwErrno(int fd, std::string const& what) {
+    auto const error = errno;
+    close(fd);
+    throw std::system_error{error, std::generic_category(), what};
+}
+}  // namespace
+
+LightsServer::Connection::~Connection() {
+    task = {};
+    close(fd);
+}
+
+LightsServer::LightsServer(std::string path)
+    : m_path{std::move(path)},
+      m_listen{socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0)},
+      m_buffer(BUFFER_WORDS) {
+    if (m_listen < 0) {
+        throw std::system_error{errno, std::generic_category(), "socket"};
+    }
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (m_path.size() >= sizeof(address.sun_path)) {
+        close(m_listen);
+        throw std::invalid_argument{"Socket path too long: " + m_path};
+    }
+    std::copy(m_path.begin(), m_path.end(), std::begin(address.sun_path));
+    // replace a socket file left behind by a server that did not exit cleanly
+    unlink(m_path.c_str());
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast): socket API
+    if (bind(m_listen, reinterpret_cast<sockaddr const*>(&address), sizeof(address)) != 0) {
+        throwErrno(m_listen, "bind " + m_path);
+    }
+    if (listen(m_listen, SOMAXCONN) != 0) {
+        unlink(m_path.c_str());
+        throwErrno(m_listen, "listen " + m_path);
+    }
+    m_reactor.add(m_listen, m_listenWatch);
+    m_acceptor = accept();
+    m_acceptor.start();
+}
+
+LightsServer::~LightsServer() {
+    m_acceptor = {};
+    m_connections.clear();
+    close(m_listen);
+    unlink(m_path.c_str());
+}
+
+void LightsServer::adopt(int fd) {
+    auto const flags = fcntl(fd, F_GETFL);
+    if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) != 0) {
+        throwErrno(fd, "fcntl " + std::to_string(fd));
+    }
+    auto connection = std::make_unique<Connection>(fd);
+    m_reactor.add(fd, connection->watch);
+    auto& served = *connection;
+    m_connections.emplace(fd, std::move(connection));
+    ++m_stats.opened;
+    m_stats.peak = std::max<uint64_t>(m_stats.peak, m_connections.size());
+    served.task = serve(served);
+    served.task.start();
+}
+
+size_t LightsServer::runOnce(std::chrono::milliseconds timeout) {
+    auto const resumed = m_reactor.runOnce(timeout);
+    reap();
+    if (m_acceptor.done()) {
+        // the acceptor only completes with an exception
+        m_acceptor.result();
+    }
+    return resumed;
+}
+
+Task<> LightsServer::accept() {
+    while (true) {
+        auto const fd = accept4(m_listen, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd >= 0) {
+            adopt(fd);
+        } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            co_await Reactor::readable(m_listenWatch);
+        } else if (errno == EMFILE || errno == ENFILE) {
+            // out of descriptors, retry once connections were served and possibly closed
+            co_await m_reactor.yield();
+        } else if (errno != EINTR && errno != ECONNABORTED) {
+            throw std::system_error{errno, std::generic_category(), "accept " + m_path};
+        }
+    }
+}
+
+Task<> LightsServer::serve(Connection& connection) {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast): bytes of the words of the buffer
+    auto* const buffer = reinterpret_cast<std::byte*>(m_buffer.data());
+    auto const capacity = m_buffer.size() * sizeof(uint32_t);
+    while (true) {
+        // continue a frame received partially by the previous read; frames are whole words, so they stay aligned
+        auto const pending = connection.pending.size();
+        std::copy(connection.pending.begin(), connection.pending.end(), buffer);
+        auto const received = read(connection.fd, buffer + pending, capacity - pending);
+        if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            co_await Reactor::readable(connection.watch);
+            continue;
+        }
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        if (received <= 0 || !consume(connection, pending + static_cast<size_t>(received))) {
+            // closed by the client (a partial frame is dropped), failed, or sent garbage
+            break;
+        }
+        if (pending + static_cast<size_t>(received) == capacity) {
+            // more is likely waiting, give the other connections a turn first
+            co_await m_reactor.yield();
+        }
+    }
+    m_stats.lights += connection.lights.getLights();
+    m_finished.push_back(connection.fd);
+}
+
+bool LightsServer::consume(Connection& connection, size_t size) {
+    std::span<uint32_t const> const words{m_buffer};
+    size_t offset = 0;
+    while (size - offset >= sizeof(uint32_t)) {
+        auto const count = words[offset / sizeof(uint32_t)];
+        if (count > MAX_FRAME) {
+            ++m_stats.rejected;
+            return false;
+        }
+        auto const frame = (size_t{1} + count) * sizeof(uint32_t);
+        if (size - offset < frame) {
+            break;
+        }
+        connection.lights.processInputs(words.subspan(offset / sizeof(uint32_t) + 1, count));
+        ++m_stats.frames;
+        m_stats.inputs += count;
+        offset += frame;
+    }
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast): bytes of the words of the buffer
+    auto const* const bytes = reinterpret_cast<std::byte const*>(m_buffer.data());
+    connection.pending.assign(bytes + offset, bytes + size);  // NOLINT(*-pro-bounds-pointer-arithmetic)
+    return true;
+}
+
+void LightsServer::reap() {
+    for (auto const fd : m_finished) {
+        m_connections.erase(fd);
+        ++m_stats.closed;
+    }
+    m_finished.clear();
+}
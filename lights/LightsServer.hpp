@@ -0,0 +1,155 @@
+#ifndef LIGHTSSERVER_HPP
+#define LIGHTSSERVER_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "CoRoutineLights.hpp"
+#include "Reactor.hpp"
+#include "Task.hpp"
+
+/**
+ * Server driving one co-routine lights instance per connection with inputs received over Unix domain sockets or pipes,
+ * all on one thread.
+ *
+ * Clients connect to the socket at the path given on construction and send frames, each a `uint32_t` count followed by
+ * `count` `uint32_t` inputs in host byte order. Every connection is served by a co-routine that reads whatever the
+ * connection has received into a buffer shared by all connections, hands each complete frame as a span of that buffer
+ * to the `processInputs` of its `CoRoutineLights`, keeps a partial frame for the next read, and suspends on a `Reactor`
+ * until more input arrives. The lights take the first input of a frame directly and copy the others into their input
+ * queue, which keeps its capacity from frame to frame. A connection and its lights are destroyed when the client
+ * closes it, or when it sends a frame of more than `MAX_FRAME` inputs.
+ *
+ * A suspended connection costs its co-routine frame, the frame of its lights and a descriptor, no stack and no thread,
+ * so tens of thousands of connections are served by the thread calling `runOnce`.
+ *
+ * This type is not thread-safe. All calls must be made from the thread running the loop.
+ */
+class LightsServer {
+   public:
+    /// Maximum number of inputs per frame.
+    static constexpr uint32_t MAX_FRAME = 4096;
+
+    /// Counters of the server.
+    struct Stats {
+        /// connections accepted or adopted so far
+        uint64_t opened;
+        /// connections closed so far
+        uint64_t closed;
+        /// highest number of connections open at the same time
+        uint64_t peak;
+        /// complete frames received
+        uint64_t frames;
+        /// inputs received in complete frames
+        uint64_t inputs;
+        /// connections closed because of a frame larger than `MAX_FRAME`
+        uint64_t rejected;
+        /// sum of the lights of all closed connections when they were closed
+        uint64_t lights;
+    };
+
+    /**
+     * Listen for connections on a Unix domain socket at `path`, replacing a stale socket file at that path.
+     *
+     * Throws `std::invalid_argument` if the path is too long and `std::system_error` if the socket cannot be created.
+     */
+    explicit LightsServer(std::string path);
+
+    /// Close all connections and the socket, and remove the socket file.
+    ~LightsServer();
+
+    LightsServer(LightsServer const&) = delete;
+    LightsServer(LightsServer&&) = delete;
+    LightsServer& operator=(LightsServer const&) = delete;
+    LightsServer& operator=(LightsServer&&) = delete;
+
+    /// Serve the connected descriptor `fd`, e.g. the read end of a pipe. Takes ownership of `fd`.
+    void adopt(int fd);
+
+    /**
+     * Wait up to `timeout` for input, serve all connections that received some and accept new connections. Return the
+     * number of co-routines resumed. Throws `std::system_error` if accepting connections failed.
+     */
+    size_t runOnce(std::chrono::milliseconds timeout);
+
+    /// Number of open connections.
+    [[nodiscard]] size_t connections() const noexcept {
+        return m_connections.size();
+    }
+
+    /// Counters of the server.
+    [[nodiscard]] Stats const& stats() const noexcept {
+        return m_stats;
+    }
+
+   private:
+    /// number of words in the buffer shared by all connections, holds a frame of `MAX_FRAME` inputs and its count
+    static constexpr size_t BUFFER_WORDS = 16 * 1024;
+    static_assert(BUFFER_WORDS > MAX_FRAME, "Buffer must hold a complete frame");
+
+    /// A connection and the lights it drives.
+    struct Connection {
+        /// Take ownership of the connected descriptor `fd`.
+        explicit Connection(int fd) noexcept : fd{fd} {}
+
+        /// Close the descriptor, the co-routine is destroyed first.
+        ~Connection();
+
+        Connection(Connection const&) = delete;
+        Connection(Connection&&) = delete;
+        Connection& operator=(Connection const&) = delete;
+        Connection& operator=(Connection&&) = delete;
+
+        /// the connected descriptor
+        int fd;
+        /// registration of the descriptor with the reactor
+        Reactor::Watch watch;
+        /// the lights driven by the connection, resumed inline by the connection's co-routine
+        CoRoutineLights lights;
+        /// bytes of a frame received partially by the last read
+        std::vector<std::byte> pending;
+        /// the co-routine serving the connection, declared last so that it is destroyed first
+        Task<> task;
+    };
+
+    /// accept connections while the server exists
+    Task<> accept();
+
+    /// serve `connection` until it is closed
+    Task<> serve(Connection& connection);
+
+    /**
+     * hand the complete frames among the first `size` bytes of the buffer to `connection` and keep the rest as pending,
+     * return false if a frame is too large
+     */
+    bool consume(Connection& connection, size_t size);
+
+    /// destroy connections whose co-routine completed
+    void reap();
+
+    /// path of the socket file
+    std::string m_path;
+    /// the listening socket
+    int m_listen;
+    /// the event loop
+    Reactor m_reactor;
+    /// registration of the listening socket
+    Reactor::Watch m_listenWatch;
+    /// receive buffer shared by all connections, only used between a read and the next suspension
+    std::vector<uint32_t> m_buffer;
+    /// open connections by descriptor
+    std::unordered_map<int, std::unique_ptr<Connection>> m_connections;
+    /// descriptors of connections whose co-routine completed
+    std::vector<int> m_finished;
+    /// the co-routine accepting connections
+    Task<> m_acceptor;
+    /// counters
+    Stats m_stats{};
+};
+
+#endif  // LIGHTSSERVER_HPP
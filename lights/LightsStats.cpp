@@ -0,0 +1,170 @@
+#include "LightsStats.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+namespace {
+/// all shards ever created, shards are never destroyed so that their counts survive their threads
+struct ShardRegistry {
+    std::mutex mutex;
+    /// all shards
+    std::vector<std::unique_ptr<StatsShard>> shards;
+    /// shards released by terminated threads, ready to be re-used
+    std::vector<StatsShard*> released;
+};
+
+ShardRegistry& registry() {
+    // intentionally leaked, threads may exit during shutdown
+    static auto* registry = new ShardRegistry{};  // NOLINT(cppcoreguidelines-owning-memory)
+    return *registry;
+}
+
+/// hands the shard of a thread back to the registry when the thread exits
+struct ShardReleaser {
+    explicit ShardReleaser(StatsShard*& slot) noexcept : slot{slot} {}
+
+    ShardReleaser(ShardReleaser const&) = delete;
+    ShardReleaser(ShardReleaser&&) = delete;
+    ShardReleaser& operator=(ShardReleaser const&) = delete;
+    ShardReleaser& operator=(ShardReleaser&&) = delete;
+
+    ~ShardReleaser() {
+        auto& shards = registry();
+        std::lock_guard<std::mutex> const lock{shards.mutex};
+        shards.released.push_back(slot);
+        slot = nullptr;
+    }
+
+    /// the thread-local pointer to the shard of the thread
+    StatsShard*& slot;
+};
+
+/// add `count` to the counter at `index` of `counters`
+void addCounter(LightsCounters& counters, size_t index, uint64_t count) {
+    switch (static_cast<Counter>(index)) {
+        case Counter::InitInputs:
+            counters.initInputs += count;
+            break;
+        case Counter::RunInputs:
+            counters.runInputs += count;
+            break;
+        case Counter::Transitions:
+            counters.transitions += count;
+            break;
+        case Counter::OutOfBounds:
+            counters.outOfBounds += count;
+            break;
+        case Counter::QueueWaits:
+            counters.queueWaits += count;
+            break;
+        case Counter::Resumes:
+            counters.resumes += count;
+            break;
+        case Counter::Timeouts:
+            counters.timeouts += count;
+            break;
+    }
+}
+}  // namespace
+
+LightsCounters& LightsCounters::operator+=(LightsCounters const& other) noexcept {
+    initInputs += other.initInputs;
+    runInputs += other.runInputs;
+    transitions += other.transitions;
+    outOfBounds += other.outOfBounds;
+    queueWaits += other.queueWaits;
+    resumes += other.resumes;
+    timeouts += other.timeouts;
+    return *this;
+}
+
+uint64_t LatencyHistogram::count() const noexcept {
+    uint64_t count = 0;
+    for (auto const samples : buckets) {
+        count += samples;
+    }
+    return count;
+}
+
+uint64_t LatencyHistogram::quantile(double q) const noexcept {
+    auto const total = count();
+    if (total == 0) {
+        return 0;
+    }
+    auto const rank = static_cast<uint64_t>(q * static_cast<double>(total - 1));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BUCKETS; ++i) {
+        seen += buckets.at(i);
+        if (seen > rank) {
+            return uint64_t{2} << i;
+        }
+    }
+    return uint64_t{2} << (BUCKETS - 1);
+}
+
+std::ostream& operator<<(std::ostream& out, LightsCounters const& counters) {
+    return out << "inputs=" << counters.inputs() << " init=" << counters.initInputs << " run=" << counters.runInputs
+               << " transitions=" << counters.transitions << " out_of_bounds=" << counters.outOfBounds
+               << " queue_waits=" << counters.queueWaits << " resumes=" << counters.resumes
+               << " timeouts=" << counters.timeouts;
+}
+
+std::ostream& operator<<(std::ostream& out, LightsStats const& stats) {
+    constexpr double P50 = 0.5;
+    constexpr double P99 = 0.99;
+    constexpr double P999 = 0.999;
+    return out << stats.counters << " latency_samples=" << stats.latency.count() << " latency_p50<"
+               << stats.latency.quantile(P50) << "ns latency_p99<" << stats.latency.quantile(P99) << "ns latency_p999<"
+               << stats.latency.quantile(P999) << "ns";
+}
+
+LightsCounters CounterSet::snapshot() const noexcept {
+    LightsCounters counters{};
+    for (size_t i = 0; i < COUNTERS; ++i) {
+        addCounter(counters, i, m_values.at(i).load(std::memory_order_relaxed));
+    }
+    return counters;
+}
+
+void StatsShard::addTo(LightsStats& stats) const noexcept {
+    stats.counters += counters.snapshot();
+    for (size_t i = 0; i < LatencyHistogram::BUCKETS; ++i) {
+        stats.latency.buckets.at(i) += m_latency.at(i).load(std::memory_order_relaxed);
+    }
+}
+
+StatsShard* StatsShard::acquire() noexcept {
+    auto& shards = registry();
+    StatsShard* shard{};
+    {
+        std::lock_guard<std::mutex> const lock{shards.mutex};
+        if (!shards.released.empty()) {
+            shard = shards.released.back();
+            shards.released.pop_back();
+        } else {
+            shards.shards.push_back(std::make_unique<StatsShard>());
+            shard = shards.shards.back().get();
+            // room to release every shard without allocating
+            shards.released.reserve(shards.shards.size());
+        }
+    }
+    auto*& local = slot();
+    local = shard;
+    thread_local ShardReleaser const releaser{local};
+    return shard;
+}
+
+LightsStats aggregateStats() {
+    LightsStats stats{};
+    auto& shards = registry();
+    std::lock_guard<std::mutex> const lock{shards.mutex};
+    for (auto const& shard : shards.shards) {
+        shard->addTo(stats);
+    }
+    return stats;
+}
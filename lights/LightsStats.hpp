@@ -0,0 +1,158 @@
+#ifndef LIGHTSSTATS_HPP
+#define LIGHTSSTATS_HPP
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+/**
+ * Instrumentation of lights instances: counters and a latency histogram.
+ *
+ * Every instance keeps its own counters. In addition, every thread adds to a shard of process-wide counters and of a
+ * histogram of `processInput` latencies; `aggregateStats()` sums up all shards. Instances and shards are each written
+ * by one thread at a time, so counting is a relaxed load and store without a locked instruction, readers may take a
+ * snapshot from any thread at any time. Latencies are sampled, see `Lights::LatencyProbe`.
+ *
+ * If the library is compiled with `LIGHTS_NO_STATS` defined, nothing is counted and there is no overhead.
+ */
+
+/// Things counted per instance and per thread.
+enum class Counter : uint8_t {
+    /// inputs consumed in INIT phase
+    InitInputs,
+    /// inputs consumed in RUN phase
+    RunInputs,
+    /// transitions of the lights
+    Transitions,
+    /// inputs rejected because they are out of bounds
+    OutOfBounds,
+    /// times a producer or consumer blocked on a full or empty input queue (`ThreadLights`)
+    QueueWaits,
+    /// times a suspended co-routine or fiber was resumed or scheduled to consume inputs
+    Resumes,
+    /// timers that expired before an input arrived (`TimedLights`)
+    Timeouts,
+};
+
+/// Number of `Counter` values.
+constexpr size_t COUNTERS = 7;
+
+/// Snapshot of counters.
+struct LightsCounters {
+    uint64_t initInputs;
+    uint64_t runInputs;
+    uint64_t transitions;
+    uint64_t outOfBounds;
+    uint64_t queueWaits;
+    uint64_t resumes;
+    uint64_t timeouts;
+
+    /// Number of inputs consumed in any phase.
+    [[nodiscard]] uint64_t inputs() const noexcept {
+        return initInputs + runInputs;
+    }
+
+    /// Add the counts of `other`.
+    LightsCounters& operator+=(LightsCounters const& other) noexcept;
+};
+
+/// Snapshot of a latency histogram with logarithmic buckets.
+struct LatencyHistogram {
+    /// Number of buckets. Bucket 0 counts latencies below 2 ns, bucket `i > 0` counts `[2^i, 2^(i + 1))` ns.
+    static constexpr size_t BUCKETS = 40;
+
+    /// Bucket counting a latency of `nanoseconds`.
+    static constexpr size_t bucket(uint64_t nanoseconds) noexcept {
+        auto const index = nanoseconds < 2 ? 0 : static_cast<size_t>(std::bit_width(nanoseconds)) - 1;
+        return index < BUCKETS ? index : BUCKETS - 1;
+    }
+
+    /// Number of samples per bucket.
+    std::array<uint64_t, BUCKETS> buckets;
+
+    /// Number of samples.
+    [[nodiscard]] uint64_t count() const noexcept;
+
+    /// Upper bound of the bucket containing quantile `q` (between 0 and 1) in nanoseconds, 0 without samples.
+    [[nodiscard]] uint64_t quantile(double q) const noexcept;
+};
+
+/// Snapshot of process-wide instrumentation.
+struct LightsStats {
+    LightsCounters counters;
+    LatencyHistogram latency;
+};
+
+/// Format counters as `name=value` pairs on one line.
+std::ostream& operator<<(std::ostream& out, LightsCounters const& counters);
+
+/// Format process-wide instrumentation, counters and latency quantiles, on one line.
+std::ostream& operator<<(std::ostream& out, LightsStats const& stats);
+
+/// Live counters, written by one thread at a time, read by any thread.
+class CounterSet {
+   public:
+    /// Add `count` to `counter`. Must not be called concurrently with another `add`.
+    void add(Counter counter, uint64_t count = 1) noexcept {
+        auto& value = m_values[static_cast<size_t>(counter)];
+        value.store(value.load(std::memory_order_relaxed) + count, std::memory_order_relaxed);
+    }
+
+    /// Add `count` to `counter`, safe to call concurrently from several threads. Use on slow paths only.
+    void addShared(Counter counter, uint64_t count = 1) noexcept {
+        m_values[static_cast<size_t>(counter)].fetch_add(count, std::memory_order_relaxed);
+    }
+
+    /// Current values.
+    [[nodiscard]] LightsCounters snapshot() const noexcept;
+
+   private:
+    /// one value per counter
+    std::array<std::atomic<uint64_t>, COUNTERS> m_values{};
+};
+
+/// One thread's share of the process-wide instrumentation.
+class StatsShard {
+   public:
+    /// Shard of the calling thread, created on first use.
+    static StatsShard& local() noexcept {
+        auto*& shard = slot();
+        if (shard == nullptr) {
+            shard = acquire();
+        }
+        return *shard;
+    }
+
+    /// Process-wide counters.
+    CounterSet counters;
+
+    /// Record a latency sample.
+    void recordLatency(uint64_t nanoseconds) noexcept {
+        auto& value = m_latency[LatencyHistogram::bucket(nanoseconds)];
+        value.store(value.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    /// Add the current values of this shard to `stats`.
+    void addTo(LightsStats& stats) const noexcept;
+
+   private:
+    /// the calling thread's shard, trivially initialized so that access is a plain thread-local load
+    static StatsShard*& slot() noexcept {
+        thread_local StatsShard* shard = nullptr;
+        return shard;
+    }
+
+    /// take a shard released by a terminated thread or create a new one, release it when the calling thread exits
+    static StatsShard* acquire() noexcept;
+
+    /// latency samples per bucket
+    std::array<std::atomic<uint64_t>, LatencyHistogram::BUCKETS> m_latency{};
+};
+
+/// Sum of the instrumentation of all threads, including terminated ones.
+LightsStats aggregateStats();
+
+#endif  // LIGHTSSTATS_HPP
@@ -0,0 +1,49 @@
+#ifndef LIGHTSVARIANT_HPP
+#define LIGHTSVARIANT_HPP
+
+#include <concepts>
+#include <cstdint>
+#include <span>
+#include <variant>
+
+#include "CoRoutineLights.hpp"
+#include "FiberLights.hpp"
+#include "StateMachineLights.hpp"
+#include "ThreadLights.hpp"
+
+/**
+ * Static dispatch alongside the virtual `Lights` interface.
+ *
+ * All implementations are `final`, so calls on a concrete type are resolved at compile time and can be inlined.
+ * Generic drivers are written as templates constrained by `LightsType` and are instantiated per concrete type. Where
+ * the implementation is only known at run time, a `LightsVariant` holds one of them by value and dispatches with
+ * `std::visit` (a jump on the variant index instead of an indirect call through the vtable).
+ */
+
+/// Types that can be driven like `Lights`.
+template <typename L>
+concept LightsType = requires(L& lights, L const& constLights, uint32_t input, std::span<uint32_t const> inputs) {
+    lights.processInput(input);
+    lights.processInputs(inputs);
+    { constLights.getLights() } -> std::convertible_to<uint32_t>;
+};
+
+/// One of the lights implementations, held by value. Construct with `std::in_place_type<T>`.
+using LightsVariant = std::variant<StateMachineLights, CoRoutineLights, ThreadLights, FiberLights>;
+
+/// Provide an input to the implementation held by `lights`.
+inline void processInput(LightsVariant& lights, uint32_t input) {
+    std::visit([input](auto& alternative) { alternative.processInput(input); }, lights);
+}
+
+/// Provide several inputs to the implementation held by `lights`.
+inline void processInputs(LightsVariant& lights, std::span<uint32_t const> inputs) {
+    std::visit([inputs](auto& alternative) { alternative.processInputs(inputs); }, lights);
+}
+
+/// Get current lights of the implementation held by `lights`.
+inline uint32_t getLights(LightsVariant const& lights) {
+    return std::visit([](auto const& alternative) { return alternative.getLights(); }, lights);
+}
+
+#endif  // LIGHTSVARIANT_HPP
@@ -0,0 +1,71 @@
+#include "MappedFile.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <string>
+#include <system_error>
+
+namespace {
+/// throw the error indicated by `errno` for `what`
+[[noreturn]] void throwErrno(std::string const& what) {
+    throw std::system_error{errno, std::generic_category(), what};
+}
+
+/// size of a memory page
+size_t pageSize() {
+    static auto const size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    return size;
+}
+}  // namespace
+
+MappedFile::MappedFile(std::string const& path) {
+    auto const fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);  // NOLINT(cppcoreguidelines-pro-type-vararg)
+    if (fd < 0) {
+        throwErrno("open " + path);
+    }
+    struct stat status {};
+    if (fstat(fd, &status) != 0) {
+        auto const error = errno;
+        close(fd);
+        errno = error;
+        throwErrno("stat " + path);
+    }
+    m_size = static_cast<size_t>(status.st_size);
+    if (m_size > 0) {
+        auto* data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {  // NOLINT(cppcoreguidelines-pro-type-cstyle-cast): macro
+            auto const error = errno;
+            close(fd);
+            errno = error;
+            throwErrno("mmap " + path);
+        }
+        m_data = static_cast<std::byte const*>(data);
+    }
+    // the mapping stays valid after the descriptor is closed
+    close(fd);
+}
+
+MappedFile::~MappedFile() {
+    if (m_data != nullptr) {
+        munmap(const_cast<std::byte*>(m_data), m_size);  // NOLINT(cppcoreguidelines-pro-type-const-cast)
+    }
+}
+
+void MappedFile::adviseSequential() const noexcept {
+    if (m_data != nullptr) {
+        madvise(const_cast<std::byte*>(m_data), m_size, MADV_SEQUENTIAL);  // NOLINT(*-pro-type-const-cast)
+    }
+}
+
+void MappedFile::release(size_t end) const noexcept {
+    // only whole pages can be dropped
+    auto const length = (end < m_size ? end : m_size) / pageSize() * pageSize();
+    if (m_data != nullptr && length > 0) {
+        madvise(const_cast<std::byte*>(m_data), length, MADV_DONTNEED);  // NOLINT(*-pro-type-const-cast)
+    }
+}
@@ -0,0 +1,46 @@
+#ifndef MAPPEDFILE_HPP
+#define MAPPEDFILE_HPP
+
+#include <cstddef>
+#include <span>
+#include <string>
+
+/**
+ * Read-only memory mapping of a whole file.
+ *
+ * The contents are paged in by the kernel on first access, nothing is read or copied up front, so files much larger
+ * than the available memory can be processed. Pages already processed can be dropped from the mapping with `release`
+ * to keep the resident set small while streaming.
+ */
+class MappedFile {
+   public:
+    /// Map the file at `path`. Throws `std::system_error` if the file cannot be opened or mapped.
+    explicit MappedFile(std::string const& path);
+
+    /// Unmap the file.
+    ~MappedFile();
+
+    MappedFile(MappedFile const&) = delete;
+    MappedFile(MappedFile&&) = delete;
+    MappedFile& operator=(MappedFile const&) = delete;
+    MappedFile& operator=(MappedFile&&) = delete;
+
+    /// The contents of the file.
+    [[nodiscard]] std::span<std::byte const> data() const noexcept {
+        return {m_data, m_size};
+    }
+
+    /// Tell the kernel that the file will be read sequentially, so that it reads ahead aggressively.
+    void adviseSequential() const noexcept;
+
+    /// Drop the pages covering bytes `[0, end)` from the resident set, they are read again if accessed later.
+    void release(size_t end) const noexcept;
+
+   private:
+    /// start of the mapping, `nullptr` for empty files
+    std::byte const* m_data{};
+    /// size of the file
+    size_t m_size{};
+};
+
+#endif  // MAPPEDFILE_HPP
@@ -0,0 +1,118 @@
+#ifndef MPSCQUEUE_HPP
+#define MPSCQUEUE_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <utility>
+#include <vector>
+
+/**
+ * Bounded lock-free multi-producer single-consumer queue.
+ *
+ * Producers claim a run of slots with a single compare-and-swap on the enqueue position, write their values and publish
+ * each slot with a release store of its sequence number (like `RingBufferSink`, after Dmitry Vyukov's bounded queue).
+ * Producers never wait for each other: a producer that is preempted between claiming and publishing only delays the
+ * consumer, not other producers. The consumer takes all published values at once with `popAll` and frees their slots
+ * with a single store of the dequeue position, which producers read to find out how many slots are free.
+ *
+ * Pushing and popping never allocate. The queue does not block, callers implement waiting on top of it.
+ */
+template <typename T>
+class MpscQueue {
+   public:
+    /// Create an empty queue with room for at least `capacity` values; the capacity is rounded up to a power of two.
+    explicit MpscQueue(size_t capacity)
+        : m_slots{std::make_unique<Slot[]>(std::bit_ceil(std::max<size_t>(capacity, 2)))},  // NOLINT(*-c-arrays)
+          m_mask{std::bit_ceil(std::max<size_t>(capacity, 2)) - 1} {}
+
+    /// Number of values that fit into the queue.
+    [[nodiscard]] size_t capacity() const noexcept {
+        return m_mask + 1;
+    }
+
+    /// Push a value unless the queue is full, return `true` if the value was pushed. Thread-safe.
+    bool tryPush(T value) noexcept {
+        return tryPush(std::span<T const>{&value, 1}) == 1;
+    }
+
+    /**
+     * Push as many values from the front of `values` as there are free slots, return the number of values pushed.
+     *
+     * The values pushed by one call are consecutive in the queue. Thread-safe.
+     */
+    size_t tryPush(std::span<T const> values) noexcept {
+        while (true) {
+            // load the dequeue position first, so that it is never ahead of the enqueue position
+            auto const dequeue = m_dequeue.load(std::memory_order_acquire);
+            auto position = m_enqueue.load(std::memory_order_relaxed);
+            auto const used = position - dequeue;
+            if (used > capacity()) {
+                // preempted between the loads: the dequeue position is more than a lap behind, load both again
+                continue;
+            }
+            auto const count = std::min(values.size(), capacity() - used);
+            if (count == 0) {
+                return 0;
+            }
+            if (m_enqueue.compare_exchange_weak(position, position + count, std::memory_order_relaxed)) {
+                for (size_t i = 0; i < count; ++i) {
+                    auto& slot = m_slots[(position + i) & m_mask];
+                    slot.value = values[i];
+                    slot.sequence.store(position + i + 1, std::memory_order_release);
+                }
+                return count;
+            }
+        }
+    }
+
+    /// Return true if no value is published at the front of the queue. Must only be called by the consumer.
+    [[nodiscard]] bool empty() const noexcept {
+        auto const position = m_dequeue.load(std::memory_order_relaxed);
+        return m_slots[position & m_mask].sequence.load(std::memory_order_acquire) != position + 1;
+    }
+
+    /**
+     * Remove all values published at the front of the queue and append them to `out` in order, return their number.
+     *
+     * Stops at the first slot that is claimed but not yet published. Must only be called by the consumer.
+     */
+    size_t popAll(std::vector<T>& out) {
+        auto position = m_dequeue.load(std::memory_order_relaxed);
+        auto const start = position;
+        while (true) {
+            auto& slot = m_slots[position & m_mask];
+            if (slot.sequence.load(std::memory_order_acquire) != position + 1) {
+                break;
+            }
+            out.push_back(std::move(slot.value));
+            ++position;
+        }
+        if (position != start) {
+            // free all slots at once, producers see the values were moved out before they reuse the slots
+            m_dequeue.store(position, std::memory_order_release);
+        }
+        return position - start;
+    }
+
+   private:
+    /// queue slot, holds a published value if its sequence number is its position plus one
+    struct Slot {
+        std::atomic<size_t> sequence{0};
+        T value{};
+    };
+
+    /// slots, the number of slots is a power of two
+    std::unique_ptr<Slot[]> m_slots;  // NOLINT(*-avoid-c-arrays)
+    /// number of slots minus one
+    size_t m_mask;
+    /// position of the next slot to claim by producers
+    alignas(64) std::atomic<size_t> m_enqueue{0};
+    /// position of the next slot to pop, only written by the consumer
+    alignas(64) std::atomic<size_t> m_dequeue{0};
+};
+
+#endif  // MPSCQUEUE_HPP
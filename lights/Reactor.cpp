@@ -0,0 +1,68 @@
+#include "Reactor.hpp"
+
+#include <sys/epoll.h>
+#include <unistd.h>
+
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <coroutine>
+#include <cstddef>
+#include <string>
+#include <system_error>
+#include <utility>
+
+Reactor::Reactor() : m_epoll{epoll_create1(EPOLL_CLOEXEC)} {
+    if (m_epoll < 0) {
+        throw std::system_error{errno, std::generic_category(), "epoll_create1"};
+    }
+}
+
+Reactor::~Reactor() {
+    close(m_epoll);
+}
+
+void Reactor::add(int fd, Watch& watch) {
+    epoll_event event{};
+    event.events = EPOLLIN | EPOLLRDHUP | EPOLLET;
+    event.data.ptr = &watch;
+    if (epoll_ctl(m_epoll, EPOLL_CTL_ADD, fd, &event) != 0) {
+        throw std::system_error{errno, std::generic_category(), "epoll_ctl " + std::to_string(fd)};
+    }
+}
+
+void Reactor::remove(int fd) noexcept {
+    epoll_ctl(m_epoll, EPOLL_CTL_DEL, fd, nullptr);
+}
+
+size_t Reactor::runOnce(std::chrono::milliseconds timeout) {
+    std::array<epoll_event, MAX_EVENTS> events{};
+    auto const count = epoll_wait(m_epoll, events.data(), static_cast<int>(events.size()),
+                                  m_ready.empty() ? static_cast<int>(timeout.count()) : 0);
+    if (count < 0 && errno != EINTR) {
+        throw std::system_error{errno, std::generic_category(), "epoll_wait"};
+    }
+
+    size_t resumed = 0;
+    for (int i = 0; i < count; ++i) {
+        auto& watch = *static_cast<Watch*>(events.at(static_cast<size_t>(i)).data.ptr);
+        if (watch.waiting) {
+            // the co-routine may end its registration, it is not used after the resume
+            auto const waiting = std::exchange(watch.waiting, {});
+            waiting.resume();
+            ++resumed;
+        } else {
+            // the co-routine yielded or is scheduled, it sees the event when it awaits the descriptor again
+            watch.readable = true;
+        }
+    }
+
+    // co-routines yielding now are resumed by the next call, after the descriptors ready by then
+    m_resuming.swap(m_ready);
+    for (auto const handle : m_resuming) {
+        handle.resume();
+    }
+    resumed += m_resuming.size();
+    m_resuming.clear();
+    return resumed;
+}
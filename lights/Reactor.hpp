@@ -0,0 +1,133 @@
+#ifndef REACTOR_HPP
+#define REACTOR_HPP
+
+#include <chrono>
+#include <coroutine>
+#include <cstddef>
+#include <vector>
+
+#include "Scheduler.hpp"
+
+/**
+ * Single-threaded event loop resuming co-routines that wait for file descriptors to become readable, using epoll.
+ *
+ * A co-routine watches a descriptor by registering a `Watch` with `add`, reads from the descriptor until it would
+ * block, and then suspends in `co_await reactor.readable(watch)`. Descriptors are registered edge-triggered, so the
+ * kernel reports each descriptor once per arrival of new data rather than on every wait, and the loop costs one
+ * `epoll_wait` per batch of ready descriptors however many descriptors are watched. A co-routine that has more to do
+ * than is fair to do at once gives others a turn with `co_await reactor.yield()`.
+ *
+ * The reactor is also a `Scheduler`: co-routines handed to `schedule` are resumed from the loop after the ready
+ * descriptors, like co-routines resumed by `yield`.
+ *
+ * This type is not thread-safe. All calls must be made from the thread running the loop.
+ */
+class Reactor final : public Scheduler {
+   public:
+    /// Registration of a descriptor, must stay at the same address while the descriptor is registered.
+    struct Watch {
+        /// the co-routine waiting for the descriptor, empty if none
+        std::coroutine_handle<> waiting;
+        /// true if the descriptor became readable while no co-routine was waiting
+        bool readable{false};
+    };
+
+    /// Awaiter returned by `readable`, suspends until the descriptor of a watch becomes readable.
+    class Readable {
+       public:
+        explicit Readable(Watch& watch) noexcept : m_watch{watch} {}
+
+        /// do not suspend if the descriptor became readable in the meantime
+        [[nodiscard]] bool await_ready() const noexcept {
+            return m_watch.readable;
+        }
+
+        /// wait for the next event of the descriptor
+        void await_suspend(std::coroutine_handle<> awaitingCoroutine) noexcept {
+            m_watch.waiting = awaitingCoroutine;
+        }
+
+        void await_resume() noexcept {
+            m_watch.readable = false;
+        }
+
+       private:
+        /// the registration of the awaited descriptor
+        Watch& m_watch;
+    };
+
+    /// Awaiter returned by `yield`, puts the co-routine at the end of the ready-queue.
+    class Yield {
+       public:
+        explicit Yield(Reactor& reactor) noexcept : m_reactor{reactor} {}
+
+        [[nodiscard]] static bool await_ready() noexcept {
+            return false;
+        }
+
+        void await_suspend(std::coroutine_handle<> awaitingCoroutine) {
+            m_reactor.schedule(awaitingCoroutine);
+        }
+
+        static void await_resume() noexcept {}
+
+       private:
+        /// the reactor resuming the co-routine
+        Reactor& m_reactor;
+    };
+
+    /// Create the epoll instance. Throws `std::system_error`.
+    Reactor();
+
+    /// Close the epoll instance. Co-routines still waiting are not resumed, they are owned by whoever started them.
+    ~Reactor() override;
+
+    Reactor(Reactor const&) = delete;
+    Reactor(Reactor&&) = delete;
+    Reactor& operator=(Reactor const&) = delete;
+    Reactor& operator=(Reactor&&) = delete;
+
+    /**
+     * Watch the non-blocking descriptor `fd` for input, including end of file and errors. Throws `std::system_error`.
+     *
+     * The registration ends when the descriptor is closed or `remove`d.
+     */
+    void add(int fd, Watch& watch);
+
+    /// Stop watching `fd`, which is still open.
+    void remove(int fd) noexcept;
+
+    /// Suspend the calling co-routine until the descriptor of `watch` has new input.
+    [[nodiscard]] static Readable readable(Watch& watch) noexcept {
+        return Readable{watch};
+    }
+
+    /// Suspend the calling co-routine and resume it after the co-routines that are ready now.
+    [[nodiscard]] Yield yield() noexcept {
+        return Yield{*this};
+    }
+
+    /// Put a suspended co-routine on the ready-queue.
+    void schedule(std::coroutine_handle<> handle) override {
+        m_ready.push_back(handle);
+    }
+
+    /**
+     * Wait up to `timeout` for descriptors to become readable, resume the co-routines waiting for them and then the
+     * co-routines on the ready-queue. Does not wait if the ready-queue is not empty. Return the number of resumes.
+     */
+    size_t runOnce(std::chrono::milliseconds timeout);
+
+   private:
+    /// maximum number of events taken from the kernel per `epoll_wait`
+    static constexpr size_t MAX_EVENTS = 256;
+
+    /// the epoll instance
+    int m_epoll;
+    /// co-routines to resume after the ready descriptors
+    std::vector<std::coroutine_handle<>> m_ready;
+    /// co-routines being resumed by `runOnce`, swapped with `m_ready` so that yielding co-routines wait a round
+    std::vector<std::coroutine_handle<>> m_resuming;
+};
+
+#endif  // REACTOR_HPP
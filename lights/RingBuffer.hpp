@@ -0,0 +1,98 @@
+#ifndef RINGBUFFER_HPP
+#define RINGBUFFER_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <span>
+#include <utility>
+#include <vector>
+
+/**
+ * Fixed capacity first-in-first-out buffer.
+ *
+ * The storage is allocated once on construction, pushing and popping never allocate. This type is not thread-safe,
+ * users need to provide their own synchronization.
+ */
+template <typename T>
+class RingBuffer {
+   public:
+    /// Create an empty buffer which can hold up to `capacity` elements (at least one).
+    explicit RingBuffer(size_t capacity) : m_data(capacity > 0 ? capacity : 1) {}
+
+    /// Number of elements that fit into the buffer.
+    [[nodiscard]] size_t capacity() const noexcept {
+        return m_data.size();
+    }
+
+    /// Number of elements currently stored.
+    [[nodiscard]] size_t size() const noexcept {
+        return m_size;
+    }
+
+    /// Return true if there are no elements stored.
+    [[nodiscard]] bool empty() const noexcept {
+        return m_size == 0;
+    }
+
+    /// Return true if no more elements can be pushed.
+    [[nodiscard]] bool full() const noexcept {
+        return m_size == m_data.size();
+    }
+
+    /**
+     * Append an element at the back.
+     *
+     * Must only be called if the buffer is not `full()`.
+     */
+    void push(T value) {
+        assert(!full() && "Push to full ring buffer");
+        auto tail = m_head + m_size;
+        if (tail >= m_data.size()) {
+            tail -= m_data.size();
+        }
+        m_data[tail] = std::move(value);
+        ++m_size;
+    }
+
+    /// Append as many elements of `values` as fit, return the number of elements appended.
+    size_t push(std::span<T const> values) {
+        auto const count = std::min(values.size(), m_data.size() - m_size);
+        for (size_t i = 0; i < count; ++i) {
+            push(values[i]);
+        }
+        return count;
+    }
+
+    /**
+     * Remove and return the element at the front.
+     *
+     * Must only be called if the buffer is not `empty()`.
+     */
+    T pop() {
+        assert(!empty() && "Pop from empty ring buffer");
+        T value = std::move(m_data[m_head]);
+        if (++m_head == m_data.size()) {
+            m_head = 0;
+        }
+        --m_size;
+        return value;
+    }
+
+    /// Remove all elements and append them to `out` in order.
+    void popAll(std::vector<T>& out) {
+        while (!empty()) {
+            out.push_back(pop());
+        }
+    }
+
+   private:
+    /// element storage
+    std::vector<T> m_data;
+    /// index of the front element
+    size_t m_head{};
+    /// number of elements stored
+    size_t m_size{};
+};
+
+#endif  // RINGBUFFER_HPP
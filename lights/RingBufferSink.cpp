@@ -0,0 +1,127 @@
+#include "RingBufferSink.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <utility>
+
+namespace {
+/// shortest sleep of the drainer thread when there is nothing to do
+constexpr auto MIN_BACKOFF = std::chrono::microseconds{1};
+/// longest sleep of the drainer thread when there is nothing to do, it parks if there is still nothing to do after it
+constexpr auto MAX_BACKOFF = std::chrono::milliseconds{1};
+/// number of events the console sink can buffer
+constexpr size_t CONSOLE_CAPACITY = 64 * 1024;
+}  // namespace
+
+RingBufferSink::RingBufferSink(size_t capacity, Handler handler)
+    : m_slots{std::make_unique<Slot[]>(std::bit_ceil(std::max<size_t>(capacity, 2)))},  // NOLINT(*-avoid-c-arrays)
+      m_mask{std::bit_ceil(std::max<size_t>(capacity, 2)) - 1},
+      m_handler{std::move(handler)} {
+    for (size_t i = 0; i <= m_mask; ++i) {
+        m_slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    // start draining only once the slots are initialized
+    m_thread = std::thread{[this]() { this->drain(); }};
+}
+
+RingBufferSink::~RingBufferSink() {
+    m_stop.store(true);
+    wake();
+    m_thread.join();
+}
+
+RingBufferSink& RingBufferSink::console() {
+    static RingBufferSink sink{CONSOLE_CAPACITY, [](TransitionEvent const& event) { std::cout << event; }};
+    return sink;
+}
+
+void RingBufferSink::record(TransitionEvent const& event) noexcept {
+    auto position = m_enqueue.load(std::memory_order_relaxed);
+    while (true) {
+        auto& slot = m_slots[position & m_mask];
+        auto const sequence = slot.sequence.load(std::memory_order_acquire);
+        auto const difference = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(position);
+        if (difference == 0) {
+            // slot is free, try to claim it
+            // sequentially consistent, so that the claim and the check of `m_sleeping` after it pair with `drain`
+            if (m_enqueue.compare_exchange_weak(position, position + 1, std::memory_order_seq_cst,
+                                                std::memory_order_relaxed)) {
+                slot.event = event;
+                slot.sequence.store(position + 1, std::memory_order_release);
+                wake();
+                return;
+            }
+        } else if (difference < 0) {
+            // slot still holds an event from the previous round, the buffer is full
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        } else {
+            // another producer claimed the slot, retry with the current position
+            position = m_enqueue.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+void RingBufferSink::flush() const {
+    auto const target = m_enqueue.load();
+    while (m_dequeue.load(std::memory_order_acquire) < target) {
+        std::this_thread::sleep_for(MIN_BACKOFF);
+    }
+}
+
+void RingBufferSink::drain() {
+    auto backoff = std::chrono::duration_cast<std::chrono::microseconds>(MIN_BACKOFF);
+    while (!m_stop.load()) {
+        if (drainOnce() > 0) {
+            backoff = MIN_BACKOFF;
+        } else if (backoff < MAX_BACKOFF) {
+            std::this_thread::sleep_for(backoff);
+            backoff = std::min<std::chrono::microseconds>(backoff * 2, MAX_BACKOFF);
+        } else {
+            // announce that the drainer is about to park, then check for claimed slots; a producer either sees the
+            // announcement or claimed its slot before the check (sequentially consistent on both sides). A claimed
+            // slot that is not published yet keeps the drainer backing off until it is.
+            m_sleeping.store(true, std::memory_order_seq_cst);
+            if (m_enqueue.load(std::memory_order_seq_cst) != m_dequeue.load(std::memory_order_relaxed) ||
+                m_stop.load(std::memory_order_seq_cst)) {
+                m_sleeping.store(false, std::memory_order_relaxed);
+                continue;
+            }
+            m_sleeping.wait(true, std::memory_order_acquire);
+            backoff = MIN_BACKOFF;
+        }
+    }
+    drainOnce();
+}
+
+void RingBufferSink::wake() noexcept {
+    // no fence: the preceding claim of a slot, or the store of the stop flag, is sequentially consistent; the load is
+    // a read of a line that is only written when the drainer parks
+    if (m_sleeping.load(std::memory_order_seq_cst) && m_sleeping.exchange(false, std::memory_order_acq_rel)) {
+        m_sleeping.notify_one();
+    }
+}
+
+size_t RingBufferSink::drainOnce() {
+    auto position = m_dequeue.load(std::memory_order_relaxed);
+    auto const start = position;
+    while (true) {
+        auto& slot = m_slots[position & m_mask];
+        if (slot.sequence.load(std::memory_order_acquire) != position + 1) {
+            break;
+        }
+        m_handler(slot.event);
+        // free the slot for the next round
+        slot.sequence.store(position + m_mask + 1, std::memory_order_release);
+        ++position;
+        m_dequeue.store(position, std::memory_order_release);
+    }
+    return position - start;
+}
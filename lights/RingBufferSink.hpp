@@ -0,0 +1,85 @@
+#ifndef RINGBUFFERSINK_HPP
+#define RINGBUFFERSINK_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <thread>
+
+#include "TransitionSink.hpp"
+
+/**
+ * Sink recording events into a bounded lock-free ring buffer, drained by a background thread.
+ *
+ * Producers claim a slot with a single compare-and-swap and publish the event with a release store (bounded
+ * multi-producer queue with per-slot sequence numbers as described by Dmitry Vyukov). They never block and never
+ * allocate: if the ring buffer is full, the event is dropped and counted. The drainer thread passes the events in
+ * order to a handler, which formats or persists them; it backs off with increasing sleeps while there is nothing to do,
+ * then parks until the next event is recorded, so that an idle sink costs no wakeups.
+ */
+class RingBufferSink final : public TransitionSink {
+   public:
+    /// Function called by the drainer thread for every event.
+    using Handler = std::function<void(TransitionEvent const&)>;
+
+    /// Create a sink with room for at least `capacity` events and start the drainer thread.
+    RingBufferSink(size_t capacity, Handler handler);
+
+    /// Drain all events recorded so far and stop the drainer thread.
+    ~RingBufferSink() override;
+
+    RingBufferSink(RingBufferSink const&) = delete;
+    RingBufferSink(RingBufferSink&&) = delete;
+    RingBufferSink& operator=(RingBufferSink const&) = delete;
+    RingBufferSink& operator=(RingBufferSink&&) = delete;
+
+    /// Process-wide sink formatting events to `std::cout`, created with its drainer thread on first use.
+    static RingBufferSink& console();
+
+    /// Record an event, drop it if the ring buffer is full.
+    void record(TransitionEvent const& event) noexcept override;
+
+    /// Block until all events recorded before the call are handled.
+    void flush() const;
+
+    /// Number of events dropped because the ring buffer was full.
+    [[nodiscard]] size_t dropped() const noexcept {
+        return m_dropped.load(std::memory_order_relaxed);
+    }
+
+   private:
+    /// ring buffer slot, the sequence number tells whether the slot is free or holds an event
+    struct Slot {
+        std::atomic<size_t> sequence;
+        TransitionEvent event;
+    };
+
+    /// main loop of the drainer thread
+    void drain();
+    /// handle all published events, return the number of events handled
+    size_t drainOnce();
+    /// wake up the drainer thread if it is parked, after a sequentially consistent claim of a slot or stop request
+    void wake() noexcept;
+
+    /// slots, the number of slots is a power of two
+    std::unique_ptr<Slot[]> m_slots;  // NOLINT(*-avoid-c-arrays)
+    /// number of slots minus one
+    size_t m_mask;
+    /// handler called for every event
+    Handler m_handler;
+    /// position of next slot to claim by producers
+    alignas(64) std::atomic<size_t> m_enqueue{0};
+    /// number of events handled, only written by the drainer thread
+    alignas(64) std::atomic<size_t> m_dequeue{0};
+    /// number of dropped events
+    std::atomic<size_t> m_dropped{0};
+    /// set to stop the drainer thread
+    std::atomic<bool> m_stop{false};
+    /// true while the drainer thread is parked or about to park
+    std::atomic<bool> m_sleeping{false};
+    /// the drainer thread, started once the slots are initialized
+    std::thread m_thread;
+};
+
+#endif  // RINGBUFFERSINK_HPP
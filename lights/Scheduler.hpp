@@ -0,0 +1,26 @@
+#ifndef SCHEDULER_HPP
+#define SCHEDULER_HPP
+
+#include <coroutine>
+
+/**
+ * Interface of a scheduling sub-system which resumes suspended co-routines.
+ *
+ * Awaitables that complete hand the awaiting co-routine to a scheduler instead of resuming it inline in the caller's
+ * context.
+ */
+class Scheduler {
+   public:
+    Scheduler() = default;
+    virtual ~Scheduler() = default;
+
+    Scheduler(Scheduler const&) = delete;
+    Scheduler(Scheduler&&) = delete;
+    Scheduler& operator=(Scheduler const&) = delete;
+    Scheduler& operator=(Scheduler&&) = delete;
+
+    /// Queue a suspended co-routine to be resumed later by the scheduler.
+    virtual void schedule(std::coroutine_handle<> handle) = 0;
+};
+
+#endif  // SCHEDULER_HPP
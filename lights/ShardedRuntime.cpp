@@ -0,0 +1,223 @@
+#include "ShardedRuntime.hpp"
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <latch>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "FiberLights.hpp"
+
+namespace {
+/// CPUs the calling thread may run on, in ascending order; empty if unknown
+std::vector<int> allowedCpus() {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    std::vector<int> cpus;
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            if (CPU_ISSET(cpu, &set)) {
+                cpus.push_back(cpu);
+            }
+        }
+    }
+    return cpus;
+}
+}  // namespace
+
+ShardedRuntime::ShardedRuntime(size_t instances, size_t shards, size_t capacity, bool pin) : m_size{instances} {
+    shards = std::max<size_t>(shards, 1);
+    auto const cpus = pin ? allowedCpus() : std::vector<int>{};
+    m_shards.reserve(shards);
+    for (size_t i = 0; i < shards; ++i) {
+        m_shards.push_back(std::make_unique<Shard>(capacity));
+    }
+    std::latch ready{static_cast<std::ptrdiff_t>(shards)};
+    try {
+        for (size_t i = 0; i < shards; ++i) {
+            // shard `i` hosts the IDs `i`, `i + shards`, ...
+            auto const hosted = instances / shards + (i < instances % shards ? 1 : 0);
+            auto const cpu = cpus.empty() ? -1 : cpus[i % cpus.size()];
+            m_shards[i]->thread = std::thread{[&shard = *m_shards[i], hosted, cpu, &ready]() {
+                work(shard, hosted, cpu, ready);
+            }};
+        }
+    } catch (...) {
+        // release the latch for the shards that did not start, then stop the ones that did
+        for (auto& shard : m_shards) {
+            if (!shard->thread.joinable()) {
+                ready.count_down();
+            }
+        }
+        ready.wait();
+        stop();
+        throw;
+    }
+    ready.wait();
+    for (auto& shard : m_shards) {
+        if (shard->error) {
+            stop();
+            std::rethrow_exception(shard->error);
+        }
+    }
+}
+
+ShardedRuntime::~ShardedRuntime() {
+    stop();
+}
+
+void ShardedRuntime::post(Id id, std::span<uint32_t const> inputs) {
+    if (id >= m_size) {
+        throw std::out_of_range{"Instance " + std::to_string(id) + " out of range"};
+    }
+    constexpr size_t CHUNK = 64;
+    auto& shard = *m_shards[shardOf(id)];
+    auto const instance = static_cast<uint32_t>(id / m_shards.size());
+    std::array<Message, CHUNK> messages{};
+    while (!inputs.empty()) {
+        auto const count = std::min(CHUNK, inputs.size());
+        for (size_t i = 0; i < count; ++i) {
+            messages.at(i) = {instance, inputs[i]};
+        }
+        // counted before pushing, so that the worker never processes more inputs than `drain` sees as posted
+        shard.posted.fetch_add(count, std::memory_order_release);
+        std::span<Message const> pending{messages.data(), count};
+        while (!pending.empty()) {
+            auto const progress = shard.progress.load(std::memory_order_acquire);
+            auto const pushed = shard.queue.tryPush(pending);
+            if (pushed > 0) {
+                pending = pending.subspan(pushed);
+                wake(shard);
+                continue;
+            }
+            // park until the worker took inputs from the queue
+            shard.waits.fetch_add(1, std::memory_order_relaxed);
+            shard.progress.wait(progress, std::memory_order_acquire);
+        }
+        inputs = inputs.subspan(count);
+    }
+}
+
+void ShardedRuntime::drain() {
+    for (auto& shard : m_shards) {
+        auto const posted = shard->posted.load(std::memory_order_acquire);
+        while (true) {
+            auto const progress = shard->progress.load(std::memory_order_acquire);
+            if (shard->processed.load(std::memory_order_acquire) >= posted) {
+                break;
+            }
+            shard->progress.wait(progress, std::memory_order_acquire);
+        }
+    }
+}
+
+ShardedRuntime::Stats ShardedRuntime::stats() const noexcept {
+    Stats stats{};
+    for (auto const& shard : m_shards) {
+        stats.processed += shard->processed.load(std::memory_order_relaxed);
+        stats.batches += shard->batches.load(std::memory_order_relaxed);
+        stats.parks += shard->parks.load(std::memory_order_relaxed);
+        stats.waits += shard->waits.load(std::memory_order_relaxed);
+    }
+    return stats;
+}
+
+void ShardedRuntime::work(Shard& shard, size_t instances, int cpu, std::latch& ready) {
+    if (cpu >= 0) {
+        // best effort, the worker runs unpinned if the CPU is not available
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    }
+    // the instances are created on the pinned worker, so that their memory is first touched by its core
+    try {
+        shard.lights.reserve(instances);
+        for (size_t i = 0; i < instances; ++i) {
+            shard.lights.push_back(std::make_unique<FiberLights>(shard.stacks));
+        }
+    } catch (...) {
+        shard.error = std::current_exception();
+    }
+    ready.count_down();
+
+    std::vector<Message> batch;
+    std::vector<uint32_t> inputs;
+    while (true) {
+        // a stop observed before finding the queue empty means all inputs posted before it were taken
+        auto const stopping = shard.stop.load(std::memory_order_acquire);
+        batch.clear();
+        if (shard.queue.popAll(batch) > 0) {
+            // producers may refill the queue while the batch is processed
+            shard.progress.fetch_add(1, std::memory_order_release);
+            shard.progress.notify_all();
+            dispatch(shard, batch, inputs);
+            shard.batches.fetch_add(1, std::memory_order_relaxed);
+            shard.processed.fetch_add(batch.size(), std::memory_order_release);
+            shard.progress.fetch_add(1, std::memory_order_release);
+            shard.progress.notify_all();
+            continue;
+        }
+        if (stopping) {
+            break;
+        }
+
+        // announce that the worker is about to park, then check again; a producer either sees the announcement or
+        // published its input before the check (both sides use sequentially consistent fences)
+        shard.sleeping.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!shard.queue.empty() || shard.stop.load(std::memory_order_relaxed)) {
+            shard.sleeping.store(false, std::memory_order_relaxed);
+            continue;
+        }
+        shard.parks.fetch_add(1, std::memory_order_relaxed);
+        shard.sleeping.wait(true, std::memory_order_acquire);
+    }
+
+    // interrupt the fibers on the thread that ran them
+    shard.lights.clear();
+}
+
+void ShardedRuntime::stop() noexcept {
+    for (auto& shard : m_shards) {
+        shard->stop.store(true, std::memory_order_release);
+        wake(*shard);
+    }
+    for (auto& shard : m_shards) {
+        if (shard->thread.joinable()) {
+            shard->thread.join();
+        }
+    }
+}
+
+void ShardedRuntime::dispatch(Shard& shard, std::span<Message const> batch, std::vector<uint32_t>& inputs) {
+    // inputs posted by one call are consecutive, hand them over with one switch to the instance's fiber
+    for (size_t begin = 0; begin < batch.size();) {
+        auto const instance = batch[begin].instance;
+        inputs.clear();
+        auto end = begin;
+        for (; end < batch.size() && batch[end].instance == instance; ++end) {
+            inputs.push_back(batch[end].input);
+        }
+        shard.lights[instance]->processInputs(inputs);
+        begin = end;
+    }
+}
+
+void ShardedRuntime::wake(Shard& shard) noexcept {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (shard.sleeping.load(std::memory_order_relaxed) && shard.sleeping.exchange(false, std::memory_order_acq_rel)) {
+        shard.sleeping.notify_one();
+    }
+}
@@ -0,0 +1,170 @@
+#ifndef SHARDEDRUNTIME_HPP
+#define SHARDEDRUNTIME_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <latch>
+#include <memory>
+#include <span>
+#include <thread>
+#include <vector>
+
+#include "FiberLights.hpp"
+#include "MpscQueue.hpp"
+#include "StackPool.hpp"
+
+/**
+ * Fixed set of worker threads hosting many blocking-style lights, as a replacement for a thread per `ThreadLights`.
+ *
+ * Instances are `FiberLights`, whose `run()` is written in the same sequential, blocking style as in `ThreadLights`.
+ * They are sharded by ID: instance `id` lives on shard `id % shards()`, and each shard is a worker thread pinned to a
+ * core, which owns the fibers of its instances, the stack pool they run on and one input queue for all of them.
+ * `post` routes an input to the queue of the instance's shard, an `MpscQueue` shared by all producers. The worker takes
+ * everything queued at once, hands consecutive inputs to the same instance to it in one `processInputs` call, and parks
+ * while its queue is empty.
+ *
+ * Kernel threads, wakeups and context switches are proportional to the number of shards, not to the number of
+ * instances. Switching between instances is a fiber switch within the worker thread, and an idle instance costs its
+ * lights and the touched pages of its fiber stack.
+ *
+ * Instances are created on their worker thread, so that their memory is local to the core running them, and destroyed
+ * there after all queued inputs were processed. `post` and `drain` are thread-safe; the lights may be read from any
+ * thread with `getLights()` or `published()`.
+ */
+class ShardedRuntime {
+   public:
+    /// ID to address instances hosted by the runtime.
+    using Id = size_t;
+
+    /// Default number of inputs that can be queued per shard before producers block.
+    static constexpr size_t DEFAULT_CAPACITY = 4096;
+
+    /// Counters of all shards.
+    struct Stats {
+        /// inputs processed
+        uint64_t processed;
+        /// batches taken from the queues
+        uint64_t batches;
+        /// times a worker parked on its empty queue
+        uint64_t parks;
+        /// times a producer parked on a full queue
+        uint64_t waits;
+    };
+
+    /**
+     * Create `instances` lights on `shards` worker threads (at least one), with room for `capacity` queued inputs per
+     * shard. Worker `i` is pinned to the `i`-th CPU the process may run on, modulo their number, if `pin` is set.
+     * Returns once all instances are waiting for their first input.
+     *
+     * Throws `std::system_error` if a thread cannot be started or a fiber stack cannot be mapped.
+     */
+    explicit ShardedRuntime(size_t instances, size_t shards = std::thread::hardware_concurrency(),
+                            size_t capacity = DEFAULT_CAPACITY, bool pin = true);
+
+    /// Process all queued inputs, destroy the instances and stop the worker threads.
+    ~ShardedRuntime();
+
+    ShardedRuntime(ShardedRuntime const&) = delete;
+    ShardedRuntime(ShardedRuntime&&) = delete;
+    ShardedRuntime& operator=(ShardedRuntime const&) = delete;
+    ShardedRuntime& operator=(ShardedRuntime&&) = delete;
+
+    /// Number of instances.
+    [[nodiscard]] size_t size() const noexcept {
+        return m_size;
+    }
+
+    /// Number of shards, i.e. worker threads.
+    [[nodiscard]] size_t shards() const noexcept {
+        return m_shards.size();
+    }
+
+    /// The shard hosting instance `id`.
+    [[nodiscard]] size_t shardOf(Id id) const noexcept {
+        return id % m_shards.size();
+    }
+
+    /// The instance with given ID, only its published lights may be read from other threads.
+    [[nodiscard]] Lights const& operator[](Id id) const {
+        return *m_shards[shardOf(id)]->lights[id / m_shards.size()];
+    }
+
+    /// Queue an input for instance `id`, block while its shard's queue is full. Thread-safe.
+    void post(Id id, uint32_t input) {
+        post(id, std::span<uint32_t const>{&input, 1});
+    }
+
+    /**
+     * Queue several inputs for instance `id`, block while its shard's queue is full. The inputs are consecutive in the
+     * queue if they fit, so that they are processed by one `processInputs` call. Thread-safe.
+     *
+     * Throws `std::out_of_range` for unknown instances.
+     */
+    void post(Id id, std::span<uint32_t const> inputs);
+
+    /// Wait until all inputs posted before the call are processed. Thread-safe.
+    void drain();
+
+    /// Snapshot of the counters of all shards.
+    [[nodiscard]] Stats stats() const noexcept;
+
+   private:
+    /// queued input to the instance with the shard-local index `instance`
+    struct Message {
+        uint32_t instance;
+        uint32_t input;
+    };
+
+    /// A worker thread and the instances it hosts.
+    struct alignas(64) Shard {
+        explicit Shard(size_t capacity) : queue{capacity} {}
+
+        /// inputs to the instances of the shard
+        MpscQueue<Message> queue;
+        /// stacks of the fibers of the shard
+        StackPool stacks;
+        /// the instances by shard-local index, declared after the stacks they run on
+        std::vector<std::unique_ptr<FiberLights>> lights;
+        /// inputs posted to the shard, bumped by producers before pushing
+        alignas(64) std::atomic<uint64_t> posted{0};
+        /// inputs processed by the worker
+        alignas(64) std::atomic<uint64_t> processed{0};
+        /// bumped whenever the worker took inputs from the queue or processed them, producers and `drain` park on it
+        std::atomic<uint32_t> progress{0};
+        /// true while the worker is parked or about to park on the empty queue
+        std::atomic<bool> sleeping{false};
+        /// set by the destructor to stop the worker once the queue is empty
+        std::atomic<bool> stop{false};
+        /// batches taken from the queue, written by the worker
+        std::atomic<uint64_t> batches{0};
+        /// times the worker parked, written by the worker
+        std::atomic<uint64_t> parks{0};
+        /// times a producer parked on the full queue
+        std::atomic<uint64_t> waits{0};
+        /// exception thrown while creating the instances, rethrown by the constructor
+        std::exception_ptr error;
+        /// the worker thread
+        std::thread thread;
+    };
+
+    /// create `instances` lights on `shard`, then process its inputs until the runtime is destroyed
+    static void work(Shard& shard, size_t instances, int cpu, std::latch& ready);
+
+    /// stop the worker threads once their queues are empty and wait for them
+    void stop() noexcept;
+
+    /// hand the inputs in `batch` to the instances of `shard`, using `inputs` as buffer
+    static void dispatch(Shard& shard, std::span<Message const> batch, std::vector<uint32_t>& inputs);
+
+    /// wake up the worker of `shard` if it is parked
+    static void wake(Shard& shard) noexcept;
+
+    /// number of instances
+    size_t m_size;
+    /// the shards, indexed by `shardOf`
+    std::vector<std::unique_ptr<Shard>> m_shards;
+};
+
+#endif  // SHARDEDRUNTIME_HPP
@@ -0,0 +1,68 @@
+#include "SharedMemory.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <string>
+#include <system_error>
+#include <utility>
+
+namespace {
+/// throw the error indicated by `errno` for `what`, after closing `fd`
+[[noreturn]] void throwErrno(int fd, std::string const& what) {
+    auto const error = errno;
+    close(fd);
+    throw std::system_error{error, std::generic_category(), what};
+}
+}  // namespace
+
+SharedMemory::SharedMemory(std::string name, Mode mode, size_t size)
+    : m_name{std::move(name)}, m_owner{mode == Mode::Create} {
+    if (m_owner) {
+        // replace an object left behind by a process that did not exit cleanly
+        shm_unlink(m_name.c_str());
+    }
+    auto const flags = m_owner ? O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC : O_RDWR | O_CLOEXEC;
+    auto const fd = shm_open(m_name.c_str(), flags, S_IRUSR | S_IWUSR);
+    if (fd < 0) {
+        throw std::system_error{errno, std::generic_category(), "shm_open " + m_name};
+    }
+    if (m_owner) {
+        if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+            shm_unlink(m_name.c_str());
+            throwErrno(fd, "ftruncate " + m_name);
+        }
+        m_size = size;
+    } else {
+        struct stat status {};
+        if (fstat(fd, &status) != 0) {
+            throwErrno(fd, "stat " + m_name);
+        }
+        m_size = static_cast<size_t>(status.st_size);
+    }
+    if (m_size > 0) {
+        auto* data = mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (data == MAP_FAILED) {  // NOLINT(cppcoreguidelines-pro-type-cstyle-cast): macro
+            if (m_owner) {
+                shm_unlink(m_name.c_str());
+            }
+            throwErrno(fd, "mmap " + m_name);
+        }
+        m_data = static_cast<std::byte*>(data);
+    }
+    // the mapping stays valid after the descriptor is closed
+    close(fd);
+}
+
+SharedMemory::~SharedMemory() {
+    if (m_data != nullptr) {
+        munmap(m_data, m_size);
+    }
+    if (m_owner) {
+        shm_unlink(m_name.c_str());
+    }
+}
@@ -0,0 +1,51 @@
+#ifndef SHAREDMEMORY_HPP
+#define SHAREDMEMORY_HPP
+
+#include <cstddef>
+#include <span>
+#include <string>
+
+/**
+ * Read-write mapping of a POSIX shared memory object, shared with other processes mapping the same name.
+ *
+ * The creating side sets the size and removes the name again when it is destroyed, processes that mapped the object
+ * before keep their mapping. Attaching only maps an existing object with the size it has.
+ */
+class SharedMemory {
+   public:
+    /// Whether to create a new object or attach to an existing one.
+    enum class Mode { Create, Attach };
+
+    /**
+     * Map the shared memory object `name` (e.g. "/lights"), creating it with `size` bytes in `Mode::Create`.
+     *
+     * A stale object of the same name is replaced on creation. Throws `std::system_error` if the object cannot be
+     * opened, sized or mapped.
+     */
+    SharedMemory(std::string name, Mode mode, size_t size = 0);
+
+    /// Unmap the object, and remove its name if it was created by this instance.
+    ~SharedMemory();
+
+    SharedMemory(SharedMemory const&) = delete;
+    SharedMemory(SharedMemory&&) = delete;
+    SharedMemory& operator=(SharedMemory const&) = delete;
+    SharedMemory& operator=(SharedMemory&&) = delete;
+
+    /// The contents of the object.
+    [[nodiscard]] std::span<std::byte> data() const noexcept {
+        return {m_data, m_size};
+    }
+
+   private:
+    /// name of the object
+    std::string m_name;
+    /// true if the name is removed on destruction
+    bool m_owner;
+    /// start of the mapping, `nullptr` for empty objects
+    std::byte* m_data{};
+    /// size of the object
+    size_t m_size{};
+};
+
+#endif  // SHAREDMEMORY_HPP
@@ -0,0 +1,230 @@
+#include "ShmRing.hpp"
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <memory>
+#include <new>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <utility>
+
+#include "SharedMemory.hpp"
+
+namespace {
+/// number of checks before a side sleeps, giving up the time slice in between
+constexpr int MAX_SPINS = 100;
+/// smallest and largest number of words in a ring
+constexpr size_t MIN_CAPACITY = 64;
+constexpr size_t MAX_CAPACITY = size_t{1} << 30;
+/// longest sleep on a futex, bounds the wait if the other side exits without waking us
+constexpr long WAIT_TIMEOUT_NS = 100'000'000;
+/// pause between attempts to attach to a ring that does not exist yet
+constexpr auto ATTACH_INTERVAL = std::chrono::milliseconds{10};
+
+/// number of words in a ring for a requested capacity
+uint32_t ringCapacity(size_t capacity) {
+    return static_cast<uint32_t>(std::bit_ceil(std::clamp(capacity, MIN_CAPACITY, MAX_CAPACITY)));
+}
+
+/// futex address of `word`, shared between processes (no `FUTEX_PRIVATE_FLAG`, unlike `std::atomic::wait`)
+uint32_t* futexAddress(std::atomic<uint32_t>& word) {
+    return reinterpret_cast<uint32_t*>(&word);  // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast): lock-free word
+}
+
+/// sleep while `word` holds `expected`, at most `WAIT_TIMEOUT_NS`
+void futexWait(std::atomic<uint32_t>& word, uint32_t expected) {
+    timespec timeout{0, WAIT_TIMEOUT_NS};
+    syscall(SYS_futex, futexAddress(word), FUTEX_WAIT, expected, &timeout, nullptr, 0);
+}
+
+/// wake all processes sleeping on `word`
+void futexWake(std::atomic<uint32_t>& word) {
+    syscall(SYS_futex, futexAddress(word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+/// the words following the header in `memory`
+std::span<uint32_t> ringWords(SharedMemory const& memory) {
+    auto const data = memory.data().subspan(sizeof(ShmRingHeader));
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast): words written by the other side
+    return {std::launder(reinterpret_cast<uint32_t*>(data.data())), data.size() / sizeof(uint32_t)};
+}
+}  // namespace
+
+ShmRingReader::ShmRingReader(std::string name, uint32_t instances, size_t capacity)
+    : m_memory{std::move(name), SharedMemory::Mode::Create,
+               sizeof(ShmRingHeader) + ringCapacity(capacity) * sizeof(uint32_t)},
+      m_header{new (m_memory.data().data()) ShmRingHeader{}},
+      m_ring{ringWords(m_memory)},
+      m_mask{ringCapacity(capacity) - 1} {
+    m_header->version = ShmRingHeader::VERSION;
+    m_header->capacity = ringCapacity(capacity);
+    m_header->instances = instances;
+    // producers map the object before it is initialized, they wait for the magic
+    m_header->magic.store(ShmRingHeader::MAGIC, std::memory_order_release);
+}
+
+bool ShmRingReader::wait() {
+    for (int spins = 0;; ++spins) {
+        if (m_header->head.load(std::memory_order_acquire) != m_tail) {
+            return true;
+        }
+        if (m_header->closed.load(std::memory_order_acquire) != 0) {
+            // the head is stored before the ring is closed
+            return m_header->head.load(std::memory_order_acquire) != m_tail;
+        }
+        if (spins < MAX_SPINS) {
+            std::this_thread::yield();
+            continue;
+        }
+        // announce the wait before checking the head a last time; pairs with the head and closed stores of the writer,
+        // which clears the announcement before waking, so the futex wait returns right away if it was woken already
+        m_header->readerWaiting.store(1, std::memory_order_seq_cst);
+        if (m_header->head.load(std::memory_order_seq_cst) == m_tail &&
+            m_header->closed.load(std::memory_order_seq_cst) == 0) {
+            futexWait(m_header->readerWaiting, 1);
+        }
+        m_header->readerWaiting.store(0, std::memory_order_relaxed);
+    }
+}
+
+void ShmRingReader::release() noexcept {
+    // pairs with the announcement of the wait in `reserve`
+    m_header->tail.store(m_tail, std::memory_order_seq_cst);
+    if (m_header->writerWaiting.load(std::memory_order_seq_cst) != 0) {
+        futexWake(m_header->tail);
+    }
+}
+
+ShmRingWriter::ShmRingWriter(std::string const& name) {
+    while (true) {
+        try {
+            m_memory = std::make_unique<SharedMemory>(name, SharedMemory::Mode::Attach);
+        } catch (std::system_error const& error) {
+            if (error.code() != std::errc::no_such_file_or_directory) {
+                throw;
+            }
+        }
+        // the consumer sizes the object after creating it and initializes the header after sizing it
+        if (m_memory && m_memory->data().size() >= sizeof(ShmRingHeader)) {
+            // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast): header created by the consumer
+            m_header = std::launder(reinterpret_cast<ShmRingHeader*>(m_memory->data().data()));
+            if (m_header->magic.load(std::memory_order_acquire) == ShmRingHeader::MAGIC) {
+                break;
+            }
+        }
+        m_memory.reset();
+        std::this_thread::sleep_for(ATTACH_INTERVAL);
+    }
+    if (m_header->version != ShmRingHeader::VERSION || !std::has_single_bit(m_header->capacity) ||
+        m_memory->data().size() < sizeof(ShmRingHeader) + size_t{m_header->capacity} * sizeof(uint32_t)) {
+        throw std::runtime_error{"Unsupported input ring " + name};
+    }
+    if (m_header->attached.exchange(1, std::memory_order_relaxed) != 0) {
+        throw std::runtime_error{"Input ring " + name + " has a producer already"};
+    }
+    m_ring = ringWords(*m_memory).first(m_header->capacity);
+    m_mask = m_header->capacity - 1;
+    m_head = m_header->head.load(std::memory_order_relaxed);
+    m_tail = m_header->tail.load(std::memory_order_acquire);
+}
+
+ShmRingWriter::~ShmRingWriter() {
+    close();
+}
+
+void ShmRingWriter::write(uint32_t instance, std::span<uint32_t const> inputs) {
+    if (m_closed) {
+        throw std::logic_error{"Write to closed input ring"};
+    }
+    if (instance >= instances()) {
+        throw std::out_of_range{"Instance " + std::to_string(instance) + " out of range"};
+    }
+    auto const maxBlock = m_ring.size() / 2 - 2;
+    while (!inputs.empty()) {
+        auto const count = static_cast<uint32_t>(std::min(inputs.size(), maxBlock));
+        auto const words = 2 + count;
+        auto offset = m_head & m_mask;
+        auto const contiguous = static_cast<uint32_t>(m_ring.size()) - offset;
+        if (contiguous < words) {
+            // blocks never wrap, skip the rest of the ring
+            reserve(contiguous + words);
+            m_ring[offset] = ShmRingHeader::PADDING;
+            m_head += contiguous;
+            offset = 0;
+        } else {
+            reserve(words);
+        }
+        m_ring[offset] = instance;
+        m_ring[offset + 1] = count;
+        std::copy_n(inputs.begin(), count, m_ring.begin() + offset + 2);
+        m_head += words;
+        inputs = inputs.subspan(count);
+    }
+}
+
+void ShmRingWriter::flush() noexcept {
+    // pairs with the announcement of the wait in `ShmRingReader::wait`
+    m_header->head.store(m_head, std::memory_order_seq_cst);
+    wakeReader();
+}
+
+void ShmRingWriter::close() noexcept {
+    if (m_closed) {
+        return;
+    }
+    m_closed = true;
+    flush();
+    m_header->closed.store(1, std::memory_order_seq_cst);
+    wakeReader();
+}
+
+void ShmRingWriter::wakeReader() noexcept {
+    if (m_header->readerWaiting.load(std::memory_order_seq_cst) != 0 &&
+        m_header->readerWaiting.exchange(0, std::memory_order_seq_cst) != 0) {
+        futexWake(m_header->readerWaiting);
+    }
+}
+
+void ShmRingWriter::reserve(uint32_t words) {
+    auto const fits = [&] { return m_ring.size() - (m_head - m_tail) >= words; };
+    if (fits()) {
+        return;
+    }
+    m_tail = m_header->tail.load(std::memory_order_acquire);
+    if (fits()) {
+        return;
+    }
+    // let the consumer drain what is written so far
+    flush();
+    for (int spins = 0;; ++spins) {
+        m_tail = m_header->tail.load(std::memory_order_acquire);
+        if (fits()) {
+            return;
+        }
+        if (spins < MAX_SPINS) {
+            std::this_thread::yield();
+            continue;
+        }
+        // announce the wait before checking the tail a last time; pairs with the tail store in `release`
+        m_header->writerWaiting.store(1, std::memory_order_seq_cst);
+        m_tail = m_header->tail.load(std::memory_order_seq_cst);
+        if (!fits()) {
+            futexWait(m_header->tail, m_tail);
+        }
+        m_header->writerWaiting.store(0, std::memory_order_relaxed);
+    }
+}
@@ -0,0 +1,220 @@
+#ifndef SHMRING_HPP
+#define SHMRING_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <string>
+
+#include "SharedMemory.hpp"
+
+/**
+ * Single-producer single-consumer ring of inputs to many lights instances, in POSIX shared memory.
+ *
+ * The shared memory object starts with a `ShmRingHeader`, followed by a ring of `capacity` words. Like a trace file,
+ * the ring holds blocks of a `{instance, count}` pair of words followed by `count` inputs to `instance`. Blocks never
+ * wrap around the end of the ring; a block header with instance `PADDING` marks the rest of the ring as unused.
+ *
+ * Head and tail are free-running word positions on cache lines of their own, each written by one side only. The
+ * producer copies inputs into the ring and publishes them with a single store of the head per `flush`, the consumer
+ * hands them to `processInputs` straight from the mapping and frees them with a single store of the tail per `poll`.
+ * Neither side makes a system call while the other keeps up; a side that runs out of work or space announces that it
+ * waits and sleeps on a futex, and the other side only wakes it if it announced that. The producer sleeps on the tail.
+ * The consumer sleeps on its announcement, which the producer clears before waking it, so that closing the ring, which
+ * does not move the head, cannot wake it before it sleeps.
+ */
+struct ShmRingHeader {
+    /// "LRNG" in little endian byte order
+    static constexpr uint32_t MAGIC = 0x474E524C;
+    /// current format version
+    static constexpr uint32_t VERSION = 2;
+    /// instance of a block header marking the rest of the ring as unused
+    static constexpr uint32_t PADDING = UINT32_MAX;
+
+    /// `MAGIC` once the header is initialized, stored last by the consumer
+    std::atomic<uint32_t> magic;
+    /// must be `VERSION`
+    uint32_t version;
+    /// number of words in the ring, a power of two
+    uint32_t capacity;
+    /// number of instances, instance IDs are smaller than this
+    uint32_t instances;
+
+    /// position after the last word published by the producer
+    alignas(64) std::atomic<uint32_t> head;
+    /// non-zero once the producer has published its last input
+    std::atomic<uint32_t> closed;
+    /// non-zero while the consumer sleeps (or is about to sleep) waiting for the head to move or the ring to be closed,
+    /// cleared by the producer before waking it
+    std::atomic<uint32_t> readerWaiting;
+    /// non-zero once a producer attached, there must only be one
+    std::atomic<uint32_t> attached;
+
+    /// position after the last word consumed by the consumer
+    alignas(64) std::atomic<uint32_t> tail;
+    /// non-zero while the producer sleeps (or is about to sleep) waiting for the tail to move
+    std::atomic<uint32_t> writerWaiting;
+};
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free && sizeof(std::atomic<uint32_t>) == sizeof(uint32_t),
+              "Ring indices must be plain words usable as futexes across processes");
+
+/**
+ * Consumer side of a ring, creates the shared memory object.
+ *
+ * The ring lives as long as the reader; producers attach to it by name with `ShmRingWriter`.
+ */
+class ShmRingReader {
+   public:
+    /// Default number of words in the ring.
+    static constexpr size_t DEFAULT_CAPACITY = size_t{1} << 16;
+
+    /**
+     * Create the ring `name` (e.g. "/lights") for inputs to `instances` instances, with room for at least `capacity`
+     * words. Throws `std::system_error` if the shared memory object cannot be created.
+     */
+    ShmRingReader(std::string name, uint32_t instances, size_t capacity = DEFAULT_CAPACITY);
+
+    /// Number of instances inputs may be sent to.
+    [[nodiscard]] uint32_t instances() const noexcept {
+        return m_header->instances;
+    }
+
+    /**
+     * Call `visit(instance, inputs)` for every block published so far, in order, and return the number of inputs.
+     *
+     * `inputs` is a span into the shared memory, valid until `visit` returns. Throws `std::runtime_error` if a block
+     * header is corrupt, or if the head published by the producer is not at the end of a block.
+     */
+    template <typename Visitor>
+    size_t poll(Visitor&& visit) {  // NOLINT(cppcoreguidelines-missing-std-forward): called, not forwarded
+        auto const head = m_header->head.load(std::memory_order_acquire);
+        // the head is written by another process, a corrupt head must neither be more than a ring ahead nor be
+        // stepped over by the blocks
+        if (head - m_tail > m_ring.size()) {
+            throw std::runtime_error{"Corrupt head in input ring"};
+        }
+        auto position = m_tail;
+        size_t inputs = 0;
+        while (static_cast<int32_t>(head - position) > 0) {
+            auto const offset = position & m_mask;
+            auto const room = m_ring.size() - offset;
+            auto const published = head - position;
+            auto const instance = m_ring[offset];
+            if (instance == ShmRingHeader::PADDING) {
+                if (room > published) {
+                    throw std::runtime_error{"Corrupt head in input ring"};
+                }
+                position += room;
+                continue;
+            }
+            if (instance >= instances() || room < 2 || m_ring[offset + 1] > room - 2) {
+                throw std::runtime_error{"Corrupt block in input ring"};
+            }
+            auto const count = m_ring[offset + 1];
+            if (size_t{2} + count > published) {
+                throw std::runtime_error{"Corrupt head in input ring"};
+            }
+            visit(instance, m_ring.subspan(offset + 2, count));
+            inputs += count;
+            position += 2 + count;
+        }
+        if (position != m_tail) {
+            m_tail = position;
+            release();
+        }
+        return inputs;
+    }
+
+    /**
+     * Wait until inputs are published, return `false` if the producer closed the ring and all inputs were polled.
+     *
+     * Spins briefly before it sleeps, so that a busy producer does not cost a system call per batch.
+     */
+    bool wait();
+
+   private:
+    /// publish the tail and wake the producer if it waits for space
+    void release() noexcept;
+
+    /// the shared memory object
+    SharedMemory m_memory;
+    /// the header at the start of the object
+    ShmRingHeader* m_header;
+    /// the words of the ring
+    std::span<uint32_t const> m_ring;
+    /// number of words in the ring minus one
+    uint32_t m_mask;
+    /// position of the next block to consume, published as tail
+    uint32_t m_tail{0};
+};
+
+/**
+ * Producer side of a ring created by a `ShmRingReader`, possibly in another process.
+ *
+ * Inputs are copied into the ring by `write` and become visible to the consumer with `flush` (or when the ring is
+ * full). `write` blocks while the ring is full.
+ */
+class ShmRingWriter {
+   public:
+    /**
+     * Attach to the ring `name`, waiting for its consumer to create it.
+     *
+     * Throws `std::system_error` if the shared memory object cannot be mapped, and `std::runtime_error` if it is not a
+     * ring of this version or another producer attached to it already.
+     */
+    explicit ShmRingWriter(std::string const& name);
+
+    /// Close the ring unless this was already done.
+    ~ShmRingWriter();
+
+    ShmRingWriter(ShmRingWriter const&) = delete;
+    ShmRingWriter(ShmRingWriter&&) = delete;
+    ShmRingWriter& operator=(ShmRingWriter const&) = delete;
+    ShmRingWriter& operator=(ShmRingWriter&&) = delete;
+
+    /// Number of instances inputs may be sent to.
+    [[nodiscard]] uint32_t instances() const noexcept {
+        return m_header->instances;
+    }
+
+    /**
+     * Append inputs to `instance`, in blocks of at most half the ring. Waits while the ring is full.
+     *
+     * Throws `std::out_of_range` for unknown instances and `std::logic_error` after `close`.
+     */
+    void write(uint32_t instance, std::span<uint32_t const> inputs);
+
+    /// Publish all inputs written so far and wake the consumer if it waits for them.
+    void flush() noexcept;
+
+    /// Publish all inputs written so far and tell the consumer that no more inputs follow.
+    void close() noexcept;
+
+   private:
+    /// wait until `words` words after the local head are free
+    void reserve(uint32_t words);
+
+    /// wake the consumer if it announced that it waits
+    void wakeReader() noexcept;
+
+    /// the shared memory object
+    std::unique_ptr<SharedMemory> m_memory;
+    /// the header at the start of the object
+    ShmRingHeader* m_header{};
+    /// the words of the ring
+    std::span<uint32_t> m_ring;
+    /// number of words in the ring minus one
+    uint32_t m_mask{};
+    /// position after the last word written, published as head by `flush`
+    uint32_t m_head{};
+    /// last tail read from the header, the consumer may be further ahead
+    uint32_t m_tail{};
+    /// true once `close` was called
+    bool m_closed{false};
+};
+
+#endif  // SHMRING_HPP
@@ -0,0 +1,110 @@
+#include "Snapshot.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <ios>
+#include <span>
+#include <stdexcept>
+#include <string>
+
+namespace {
+/// write the object representation of `values`
+template <typename T>
+void writeRaw(std::ofstream& out, std::span<T const> values) {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast): raw output
+    out.write(reinterpret_cast<char const*>(values.data()), static_cast<std::streamsize>(values.size_bytes()));
+}
+}  // namespace
+
+void SnapshotWriter::add(LightsState const& state) {
+    auto table = SnapshotEntry::NO_TABLE;
+    if (state.table != nullptr) {
+        auto const [it, inserted] = m_indices.try_emplace(state.table.get(), static_cast<uint32_t>(m_tables.size()));
+        if (inserted) {
+            m_tables.push_back(state.table);
+            m_states += state.table->size();
+        }
+        table = it->second;
+    }
+    m_entries.push_back({table, state.lights});
+}
+
+void SnapshotWriter::close() {
+    std::ofstream out{m_path, std::ios::binary | std::ios::trunc};
+    if (!out) {
+        throw std::runtime_error{"Cannot create snapshot " + m_path};
+    }
+    SnapshotHeader const header{SnapshotHeader::MAGIC, SnapshotHeader::VERSION, static_cast<uint32_t>(m_tables.size()),
+                                static_cast<uint32_t>(m_entries.size()), m_states};
+    writeRaw(out, std::span<SnapshotHeader const>{&header, 1});
+    for (auto const& table : m_tables) {
+        auto const size = static_cast<uint32_t>(table->size());
+        writeRaw(out, std::span<uint32_t const>{&size, 1});
+    }
+    for (auto const& table : m_tables) {
+        writeRaw(out, table->states());
+    }
+    writeRaw(out, std::span<SnapshotEntry const>{m_entries});
+    out.close();
+    if (out.fail()) {
+        throw std::runtime_error{"Writing snapshot failed"};
+    }
+}
+
+SnapshotReader::SnapshotReader(std::string const& path) : m_file{path} {
+    auto const data = m_file.data();
+    SnapshotHeader header{};
+    if (data.size() < sizeof(SnapshotHeader)) {
+        throw std::runtime_error{"Snapshot " + path + " has no header"};
+    }
+    std::memcpy(&header, data.data(), sizeof(SnapshotHeader));
+    if (header.magic != SnapshotHeader::MAGIC) {
+        throw std::runtime_error{"Not a snapshot: " + path};
+    }
+    if (header.version != SnapshotHeader::VERSION) {
+        throw std::runtime_error{"Unsupported snapshot version " + std::to_string(header.version)};
+    }
+    // check the counts section by section against the remaining size, so that no product of a count can overflow
+    auto remaining = data.size() - sizeof(SnapshotHeader);
+    if (header.tables > remaining / sizeof(uint32_t)) {
+        throw std::runtime_error{"Snapshot " + path + " is truncated or corrupt"};
+    }
+    remaining -= size_t{header.tables} * sizeof(uint32_t);
+    if (header.states > remaining / sizeof(uint32_t)) {
+        throw std::runtime_error{"Snapshot " + path + " is truncated or corrupt"};
+    }
+    remaining -= header.states * sizeof(uint32_t);
+    if (header.instances > remaining / sizeof(SnapshotEntry) ||
+        remaining != size_t{header.instances} * sizeof(SnapshotEntry)) {
+        throw std::runtime_error{"Snapshot " + path + " is truncated or corrupt"};
+    }
+
+    // sections are 4 byte aligned in the mapping
+    // NOLINTBEGIN(*-pro-type-reinterpret-cast,*-pro-bounds-pointer-arithmetic)
+    auto const* sizes = reinterpret_cast<uint32_t const*>(data.data() + sizeof(SnapshotHeader));
+    std::span<uint32_t const> states{sizes + header.tables, header.states};
+    m_entries = {reinterpret_cast<SnapshotEntry const*>(states.data() + states.size()), header.instances};
+    // NOLINTEND(*-pro-type-reinterpret-cast,*-pro-bounds-pointer-arithmetic)
+
+    // the table sizes must add up to the states before any table is interned
+    std::span<uint32_t const> const tableSizes{sizes, header.tables};
+    uint64_t total = 0;
+    for (auto const size : tableSizes) {
+        total += size;
+    }
+    if (total != header.states) {
+        throw std::runtime_error{"Snapshot " + path + " has inconsistent tables"};
+    }
+    m_tables.reserve(header.tables);
+    for (auto const size : tableSizes) {
+        m_tables.push_back(StateTableRegistry::instance().intern(states.first(size)));
+        states = states.subspan(size);
+    }
+    for (auto const& entry : m_entries) {
+        if (entry.table != SnapshotEntry::NO_TABLE && entry.table >= header.tables) {
+            throw std::runtime_error{"Snapshot " + path + " refers to unknown table"};
+        }
+    }
+}
@@ -0,0 +1,131 @@
+#ifndef SNAPSHOT_HPP
+#define SNAPSHOT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "Lights.hpp"
+#include "MappedFile.hpp"
+#include "StateTable.hpp"
+
+/**
+ * Binary snapshot of the states of many lights instances.
+ *
+ * A snapshot file starts with a `SnapshotHeader`, followed by the number of states of every distinct table, the states
+ * of all tables one after another, and one `SnapshotEntry` per instance. All values are `uint32_t` in host byte order.
+ * Instances sharing a state table share it in the snapshot as well, so the size of a snapshot grows with the number of
+ * instances and the number of distinct tables.
+ */
+struct SnapshotHeader {
+    /// "LSNP" in little endian byte order
+    static constexpr uint32_t MAGIC = 0x504E534C;
+    /// current format version
+    static constexpr uint32_t VERSION = 1;
+
+    /// must be `MAGIC`
+    uint32_t magic;
+    /// must be `VERSION`
+    uint32_t version;
+    /// number of distinct state tables
+    uint32_t tables;
+    /// number of instances
+    uint32_t instances;
+    /// total number of states in all tables
+    uint64_t states;
+};
+
+/// State of one instance in a snapshot.
+struct SnapshotEntry {
+    /// Value of `table` for instances that have not completed INIT.
+    static constexpr uint32_t NO_TABLE = std::numeric_limits<uint32_t>::max();
+
+    /// index of the state table, or `NO_TABLE`
+    uint32_t table;
+    /// the current lights
+    uint32_t lights;
+};
+
+/// Writer creating a snapshot file. The states are collected by `add` and written by `close`.
+class SnapshotWriter {
+   public:
+    /// Prepare a snapshot to be written to `path`, which is created (or truncated) by `close`.
+    explicit SnapshotWriter(std::string path) : m_path{std::move(path)} {}
+
+    /// Add the state of the next instance.
+    void add(LightsState const& state);
+
+    /// Add the state of `lights` as the next instance.
+    void add(Lights const& lights) {
+        add(lights.save());
+    }
+
+    /// Write the snapshot. Throws `std::runtime_error` if the file cannot be written.
+    void close();
+
+   private:
+    /// path of the file to write
+    std::string m_path;
+    /// the distinct tables, in order of their index
+    std::vector<StateTableRegistry::Ref> m_tables;
+    /// index of every distinct table
+    std::unordered_map<StateTable const*, uint32_t> m_indices;
+    /// one entry per instance
+    std::vector<SnapshotEntry> m_entries;
+    /// total number of states in `m_tables`
+    uint64_t m_states{};
+};
+
+/**
+ * Reader accessing a snapshot file through a memory mapping.
+ *
+ * The file is validated and its tables are interned on construction, so that restoring an instance only takes a
+ * reference to an interned table; the entries are read straight from the mapping.
+ */
+class SnapshotReader {
+   public:
+    /// Map the snapshot at `path`. Throws `std::system_error` or `std::runtime_error` if it cannot be read.
+    explicit SnapshotReader(std::string const& path);
+
+    /// Number of instances.
+    [[nodiscard]] size_t size() const noexcept {
+        return m_entries.size();
+    }
+
+    /// Number of distinct state tables.
+    [[nodiscard]] size_t tables() const noexcept {
+        return m_tables.size();
+    }
+
+    /// State of the instance at `index`, which must be less than `size()`.
+    [[nodiscard]] LightsState state(size_t index) const {
+        auto const& entry = m_entries[index];
+        return {entry.table == SnapshotEntry::NO_TABLE ? nullptr : m_tables[entry.table], entry.lights};
+    }
+
+    /**
+     * Restore `lights` to the state of the instance at `index`, see `Lights::restore`.
+     *
+     * Instances which had not completed INIT are left as they are.
+     */
+    void restore(size_t index, Lights& lights) const {
+        if (m_entries[index].table != SnapshotEntry::NO_TABLE) {
+            lights.restore(state(index));
+        }
+    }
+
+   private:
+    /// the mapping
+    MappedFile m_file;
+    /// the tables, interned
+    std::vector<StateTableRegistry::Ref> m_tables;
+    /// the entries, pointing into the mapping
+    std::span<SnapshotEntry const> m_entries;
+};
+
+#endif  // SNAPSHOT_HPP
@@ -0,0 +1,46 @@
+#ifndef SPINLOCK_HPP
+#define SPINLOCK_HPP
+
+#include <atomic>
+#include <thread>
+
+/**
+ * Minimal spin lock satisfying the standard's Lockable requirements, use with `std::lock_guard`.
+ *
+ * Intended to protect very short critical sections which are rarely contended. It is a single byte in size, so it can
+ * be embedded in every instance of a type without noticeable memory overhead.
+ */
+class SpinLock {
+   public:
+    /// Acquire the lock, spin while it is held by somebody else.
+    void lock() noexcept {
+        while (m_locked.exchange(true, std::memory_order_acquire)) {
+            // spin on a plain load to avoid bouncing the cache line while the lock is held, give up the time slice if
+            // the holder does not release it quickly (it might be preempted)
+            for (int spins = 0; m_locked.load(std::memory_order_relaxed); ++spins) {
+                if (spins >= MAX_SPINS) {
+                    std::this_thread::yield();
+                }
+            }
+        }
+    }
+
+    /// Try to acquire the lock without spinning, return `true` on success.
+    bool try_lock() noexcept {
+        return !m_locked.load(std::memory_order_relaxed) && !m_locked.exchange(true, std::memory_order_acquire);
+    }
+
+    /// Release the lock.
+    void unlock() noexcept {
+        m_locked.store(false, std::memory_order_release);
+    }
+
+   private:
+    /// number of spins before yielding
+    static constexpr int MAX_SPINS = 100;
+
+    /// true while the lock is held
+    std::atomic<bool> m_locked{false};
+};
+
+#endif  // SPINLOCK_HPP
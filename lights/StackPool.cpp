@@ -0,0 +1,83 @@
+#include "StackPool.hpp"
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <mutex>
+#include <system_error>
+
+namespace {
+/// size of a memory page
+size_t pageSize() {
+    static auto const size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    return size;
+}
+}  // namespace
+
+StackPool::StackPool(size_t stackSize)
+    : m_stackSize{(stackSize + pageSize() - 1) / pageSize() * pageSize()}, m_guardSize{pageSize()} {}
+
+StackPool::~StackPool() {
+    for (auto* base : m_free) {
+        munmap(base - m_guardSize, m_guardSize + m_stackSize);  // NOLINT(*-pro-bounds-pointer-arithmetic)
+    }
+}
+
+StackPool& StackPool::instance() {
+    // intentionally leaked, like `FramePool::instance()`
+    static auto* pool = new StackPool{};  // NOLINT(cppcoreguidelines-owning-memory)
+    return *pool;
+}
+
+StackPool::Stack StackPool::allocate() {
+    {
+        std::lock_guard<SpinLock> const lock{m_lock};
+        if (!m_free.empty()) {
+            ++m_stats.stacksInUse;
+            auto* base = m_free.back();
+            m_free.pop_back();
+            return {base, m_stackSize};
+        }
+        // room to cache every mapped stack, so that `deallocate` never allocates
+        m_free.reserve(m_stats.stacksMapped + 1);
+        ++m_stats.stacksInUse;
+        ++m_stats.stacksMapped;
+        m_stats.bytesMapped += m_guardSize + m_stackSize;
+    }
+
+    // map outside the lock, system calls are slow
+    auto* mapping = mmap(nullptr, m_guardSize + m_stackSize, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_STACK, -1, 0);
+    if (mapping == MAP_FAILED) {  // NOLINT(cppcoreguidelines-pro-type-cstyle-cast): macro
+        auto const error = errno;
+        std::lock_guard<SpinLock> const lock{m_lock};
+        --m_stats.stacksInUse;
+        --m_stats.stacksMapped;
+        m_stats.bytesMapped -= m_guardSize + m_stackSize;
+        throw std::system_error{error, std::generic_category(), "mmap stack"};
+    }
+    if (mprotect(mapping, m_guardSize, PROT_NONE) != 0) {
+        auto const error = errno;
+        munmap(mapping, m_guardSize + m_stackSize);
+        std::lock_guard<SpinLock> const lock{m_lock};
+        --m_stats.stacksInUse;
+        --m_stats.stacksMapped;
+        m_stats.bytesMapped -= m_guardSize + m_stackSize;
+        throw std::system_error{error, std::generic_category(), "mprotect stack guard"};
+    }
+    return {static_cast<std::byte*>(mapping) + m_guardSize, m_stackSize};  // NOLINT(*-pro-bounds-pointer-arithmetic)
+}
+
+void StackPool::deallocate(Stack stack) noexcept {
+    std::lock_guard<SpinLock> const lock{m_lock};
+    --m_stats.stacksInUse;
+    // capacity was reserved in `allocate`
+    m_free.push_back(stack.base);
+}
+
+StackPool::Stats StackPool::stats() const {
+    std::lock_guard<SpinLock> const lock{m_lock};
+    return m_stats;
+}
@@ -0,0 +1,81 @@
+#ifndef STACKPOOL_HPP
+#define STACKPOOL_HPP
+
+#include <cstddef>
+#include <vector>
+
+#include "SpinLock.hpp"
+
+/**
+ * Pool of fixed-size stacks for fibers.
+ *
+ * Every stack is a separate anonymous memory mapping with an inaccessible guard page below it, so a stack overflow
+ * crashes reliably instead of corrupting the neighbour. Pages are only backed by memory once they are touched, so a
+ * fiber which only uses a few hundred bytes of stack occupies about one page of memory. Stacks are cached on
+ * deallocation and handed out again, they are only unmapped when the pool is destroyed.
+ *
+ * Each stack needs two mappings, so the number of stacks is limited by `vm.max_map_count`. The pool is thread-safe.
+ */
+class StackPool {
+   public:
+    /// Default usable size of a stack.
+    static constexpr size_t DEFAULT_STACK_SIZE = 64 * 1024;
+
+    /// A stack, usable memory is `[base, base + size)`, it grows downwards from `base + size`.
+    struct Stack {
+        std::byte* base;
+        size_t size;
+    };
+
+    /// Allocation counters.
+    struct Stats {
+        /// number of stacks handed out and not returned yet
+        size_t stacksInUse;
+        /// number of stacks mapped, in use or cached
+        size_t stacksMapped;
+        /// number of bytes mapped, including guard pages; only touched pages occupy memory
+        size_t bytesMapped;
+    };
+
+    /// Create an empty pool for stacks of `stackSize` bytes, rounded up to whole pages.
+    explicit StackPool(size_t stackSize = DEFAULT_STACK_SIZE);
+
+    /// Unmap all cached stacks. All stacks must have been returned.
+    ~StackPool();
+
+    StackPool(StackPool const&) = delete;
+    StackPool(StackPool&&) = delete;
+    StackPool& operator=(StackPool const&) = delete;
+    StackPool& operator=(StackPool&&) = delete;
+
+    /// Process-wide pool with stacks of `DEFAULT_STACK_SIZE`. It is never destroyed.
+    static StackPool& instance();
+
+    /// Usable size of the stacks.
+    [[nodiscard]] size_t stackSize() const noexcept {
+        return m_stackSize;
+    }
+
+    /// Take a stack from the cache or map a new one. Throws `std::system_error` if mapping fails.
+    Stack allocate();
+
+    /// Return a stack to the cache.
+    void deallocate(Stack stack) noexcept;
+
+    /// Snapshot of the allocation counters.
+    [[nodiscard]] Stats stats() const;
+
+   private:
+    /// usable size of each stack
+    size_t m_stackSize;
+    /// size of the guard below each stack
+    size_t m_guardSize;
+    /// protects members below
+    mutable SpinLock m_lock;
+    /// cached stacks
+    std::vector<std::byte*> m_free;
+    /// allocation counters
+    Stats m_stats{};
+};
+
+#endif  // STACKPOOL_HPP
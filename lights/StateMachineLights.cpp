@@ -1,9 +1,21 @@
 #include "StateMachineLights.hpp"
 
+#include <algorithm>
+#include <cstddef>
 #include <cstdint>
-#include <iostream>
+#include <span>
+#include <vector>
+
+#include "TableSlot.hpp"
 
 void StateMachineLights::processInput(uint32_t input) {
+    LatencyProbe const probe{*this};
+    TableSlot::ReadGuard const guard{};
+    count(m_state < 2 ? Counter::InitInputs : Counter::RunInputs);
+    consume(input);
+}
+
+void StateMachineLights::consume(uint32_t input) {
     switch (m_state) {
         case 0:
             // INIT, part 0: receive number of lights
@@ -15,16 +27,70 @@ void StateMachineLights::processInput(uint32_t input) {
             // INIT, part 1: receive lights
             m_lightsVec.push_back(input);
             if (m_len == m_lightsVec.size()) {
-                m_state = 2;
+                completeInit();
             }
             break;
-        default:
+        default: {
             // RUN: activate given lights
-            if (input < m_lightsVec.size()) {
-                setLights(m_lightsVec[input]);
+            auto const& states = table();
+            if (input < states.size()) {
+                setLights(states[input]);
             } else {
-                std::cout << "Out of bounds: " << input << " >= " << m_lightsVec.size() << "\n";
+                reportOutOfBounds(input, states.size());
             }
             break;
+        }
+    }
+}
+
+void StateMachineLights::restore(LightsState const& state) {
+    checkRestore(state, m_state == 2);
+    initTable(state.table);
+    m_lightsVec = std::vector<uint32_t>{};
+    m_state = 2;
+    restoreLights(state.lights);
+}
+
+void StateMachineLights::completeInit() {
+    initTable(StateTableRegistry::instance().intern(m_lightsVec));
+    // release the private copy
+    m_lightsVec = std::vector<uint32_t>{};
+    m_state = 2;
+}
+
+void StateMachineLights::processInputs(std::span<uint32_t const> inputs) {
+    // INIT, one input at a time until the number of lights is known, then copy as many lights as possible at once
+    auto const initInputs = inputs.size();
+    while (m_state < 2 && !inputs.empty()) {
+        if (m_state == 0 || m_lightsVec.size() >= m_len) {
+            consume(inputs.front());
+            inputs = inputs.subspan(1);
+        } else {
+            auto const count = std::min(m_len - m_lightsVec.size(), inputs.size());
+            m_lightsVec.insert(m_lightsVec.end(), inputs.begin(), inputs.begin() + static_cast<std::ptrdiff_t>(count));
+            inputs = inputs.subspan(count);
+            if (m_len == m_lightsVec.size()) {
+                completeInit();
+            }
+        }
+    }
+
+    count(Counter::InitInputs, initInputs - inputs.size());
+    count(Counter::RunInputs, inputs.size());
+
+    if (inputs.empty()) {
+        return;
+    }
+
+    // RUN, no state dispatch per input and one table for the whole batch
+    TableSlot::ReadGuard const guard{};
+    auto const states = table().states();
+    auto const changedAt = changeTime();
+    for (auto input : inputs) {
+        if (input < states.size()) {
+            setLights(states[input], changedAt);
+        } else {
+            reportOutOfBounds(input, states.size());
+        }
     }
 }
@@ -3,24 +3,44 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <span>
 #include <vector>
 
 #include "Lights.hpp"
+#include "StateTable.hpp"
 
 /**
  * Implementation of lights using a simple state machine.
+ *
+ * The states are collected during INIT and then interned, see `StateTableRegistry`. In RUN, the table is read once per
+ * call of `processInput` or `processInputs`, so a replaced table is used from the next call on.
  */
-class StateMachineLights : public Lights {
+class StateMachineLights final : public Lights {
    public:
     void processInput(uint32_t input) override;
 
+    /// Process several inputs in a tight loop, state tables are copied in one go.
+    void processInputs(std::span<uint32_t const> inputs) override;
+
+    [[nodiscard]] LightsState save() const override {
+        return {tableRef(), getLights()};
+    }
+
+    void restore(LightsState const& state) override;
+
    private:
+    /// consume one input, without instrumentation
+    void consume(uint32_t input);
+
+    /// intern the collected states and enter RUN
+    void completeInit();
+
     /// state machine's state
     uint32_t m_state{};
 
     /// number of light states
     size_t m_len{};
-    /// vector that holds all light states
+    /// vector that collects the light states during INIT, empty afterwards
     std::vector<uint32_t> m_lightsVec;
 };
 
@@ -0,0 +1,83 @@
+#include "StateTable.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <span>
+
+uint64_t StateTable::hash(std::span<uint32_t const> states) noexcept {
+    // FNV-1a over the number of states and the states
+    constexpr uint64_t OFFSET = 0xCBF29CE484222325;
+    constexpr uint64_t PRIME = 0x100000001B3;
+    auto hash = (OFFSET ^ states.size()) * PRIME;
+    for (auto const state : states) {
+        hash = (hash ^ state) * PRIME;
+    }
+    return hash;
+}
+
+StateTableRegistry& StateTableRegistry::instance() {
+    // intentionally leaked, instances may be destroyed during shutdown
+    static auto* registry = new StateTableRegistry{};  // NOLINT(cppcoreguidelines-owning-memory)
+    return *registry;
+}
+
+StateTableRegistry::Ref StateTableRegistry::intern(std::span<uint32_t const> states) {
+    auto const hash = StateTable::hash(states);
+    {
+        std::lock_guard<std::mutex> const lock{m_mutex};
+        ++m_stats.interned;
+        if (auto ref = find(states, hash)) {
+            ++m_stats.hits;
+            return ref;
+        }
+    }
+
+    // create the table without holding the lock; declared before the lock, so that it is released after unlocking if
+    // another thread interned an equal table in the meantime
+    Ref const created{new StateTable{states, hash}, [this](StateTable const* table) { release(table); }};
+    std::lock_guard<std::mutex> const lock{m_mutex};
+    if (auto ref = find(states, hash)) {
+        ++m_stats.hits;
+        return ref;
+    }
+    m_tables.emplace(hash, Entry{created.get(), created});
+    ++m_stats.tables;
+    m_stats.states += states.size();
+    return created;
+}
+
+StateTableRegistry::Stats StateTableRegistry::stats() const {
+    std::lock_guard<std::mutex> const lock{m_mutex};
+    return m_stats;
+}
+
+StateTableRegistry::Ref StateTableRegistry::find(std::span<uint32_t const> states, uint64_t hash) const {
+    // compare through the raw pointer: tables are only deleted after `release` removed them, which needs the lock, and
+    // a reference promoted here but dropped before the lock is released would run `release` on this thread
+    auto const [begin, end] = m_tables.equal_range(hash);
+    for (auto it = begin; it != end; ++it) {
+        if (std::ranges::equal(it->second.table->states(), states)) {
+            // only a match is promoted, and the caller keeps it past the lock; skip it if it expired already
+            if (auto ref = it->second.ref.lock()) {
+                return ref;
+            }
+        }
+    }
+    return nullptr;
+}
+
+void StateTableRegistry::release(StateTable const* table) noexcept {
+    {
+        std::lock_guard<std::mutex> const lock{m_mutex};
+        auto const [begin, end] = m_tables.equal_range(table->hash());
+        auto const it = std::find_if(begin, end, [table](auto const& entry) { return entry.second.table == table; });
+        if (it != end) {
+            m_tables.erase(it);
+            --m_stats.tables;
+            m_stats.states -= table->size();
+        }
+    }
+    delete table;  // NOLINT(cppcoreguidelines-owning-memory): allocated by intern
+}
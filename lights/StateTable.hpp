@@ -0,0 +1,120 @@
+#ifndef STATETABLE_HPP
+#define STATETABLE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+/// Immutable table of light states, shared by all instances initialized with the same states.
+class StateTable {
+   public:
+    /// Create a table holding a copy of `states`, whose hash is `hash`. Use `StateTableRegistry::intern` instead.
+    StateTable(std::span<uint32_t const> states, uint64_t hash) : m_states(states.begin(), states.end()), m_hash{hash} {}
+
+    /// The states.
+    [[nodiscard]] std::span<uint32_t const> states() const noexcept {
+        return m_states;
+    }
+
+    /// Number of states.
+    [[nodiscard]] size_t size() const noexcept {
+        return m_states.size();
+    }
+
+    /// State at `index`, which must be less than `size()`.
+    [[nodiscard]] uint32_t operator[](size_t index) const noexcept {
+        return m_states[index];
+    }
+
+    /// Hash of the states.
+    [[nodiscard]] uint64_t hash() const noexcept {
+        return m_hash;
+    }
+
+    /// Hash of `states`, as used by the registry.
+    static uint64_t hash(std::span<uint32_t const> states) noexcept;
+
+   private:
+    /// the states
+    std::vector<uint32_t> m_states;
+    /// hash of the states
+    uint64_t m_hash;
+};
+
+/**
+ * Registry interning state tables.
+ *
+ * Once an instance has received all states in INIT, it interns them and keeps a reference to the shared table instead
+ * of a private copy. Instances with equal states share one table, so memory for states grows with the number of
+ * distinct tables instead of the number of instances, and the tables of a large fleet stay in cache. A table is
+ * removed from the registry when its last reference is dropped; interning equal states again then creates a new table,
+ * which takes four global heap allocations (the table, its states, the reference count and the registry entry). Keep a
+ * reference to tables that are repeatedly dropped and re-created, e.g. by instances created and destroyed in rounds.
+ *
+ * The registry is thread-safe. Interning takes a lock, it happens once per instance at the end of INIT.
+ */
+class StateTableRegistry {
+   public:
+    /// Shared reference to an interned table.
+    using Ref = std::shared_ptr<StateTable const>;
+
+    /// Interning counters.
+    struct Stats {
+        /// number of distinct tables alive
+        size_t tables;
+        /// number of states stored in these tables
+        size_t states;
+        /// number of calls to `intern`
+        uint64_t interned;
+        /// number of calls to `intern` that returned an existing table
+        uint64_t hits;
+    };
+
+    StateTableRegistry() = default;
+
+    /// Tables must not outlive the registry.
+    ~StateTableRegistry() = default;
+
+    StateTableRegistry(StateTableRegistry const&) = delete;
+    StateTableRegistry(StateTableRegistry&&) = delete;
+    StateTableRegistry& operator=(StateTableRegistry const&) = delete;
+    StateTableRegistry& operator=(StateTableRegistry&&) = delete;
+
+    /// Process-wide registry used by all lights implementations. It is never destroyed.
+    static StateTableRegistry& instance();
+
+    /// Return the table holding `states`, creating it if no equal table is alive.
+    Ref intern(std::span<uint32_t const> states);
+
+    /// Snapshot of the interning counters.
+    [[nodiscard]] Stats stats() const;
+
+   private:
+    /// an interned table; `ref` may have expired while the table waits for `release`
+    struct Entry {
+        StateTable const* table;
+        std::weak_ptr<StateTable const> ref;
+    };
+
+    /**
+     * return the live table in the registry equal to `states`, if any; must be called with lock held, and the result
+     * must be kept until the lock is released, since dropping the last reference calls `release`
+     */
+    Ref find(std::span<uint32_t const> states, uint64_t hash) const;
+
+    /// remove `table` from the registry and destroy it, called when its last reference is dropped
+    void release(StateTable const* table) noexcept;
+
+    /// protects members below
+    mutable std::mutex m_mutex;
+    /// interned tables by hash
+    std::unordered_multimap<uint64_t, Entry> m_tables;
+    /// interning counters
+    Stats m_stats{};
+};
+
+#endif  // STATETABLE_HPP
@@ -0,0 +1,65 @@
+#ifndef STATICLIGHTS_HPP
+#define STATICLIGHTS_HPP
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+
+#include "Lights.hpp"
+#include "StateTable.hpp"
+
+/**
+ * Implementation of lights with a state table fixed at compile time.
+ *
+ * The table is given by the template arguments, e.g., `StaticLights<OFF, RED, GREEN>`. There is no INIT phase: every
+ * input is interpreted as a state number to be activated right away. Instances do not allocate, and the lookup is a
+ * bounds check and a load from a constant table.
+ */
+template <uint32_t... States>
+class StaticLights final : public Lights {
+   public:
+    /// The state table.
+    static constexpr std::array<uint32_t, sizeof...(States)> STATES{States...};
+
+    void processInput(uint32_t input) override {
+        LatencyProbe const probe{*this};
+        count(Counter::RunInputs);
+        consume(input);
+    }
+
+    void processInputs(std::span<uint32_t const> inputs) override {
+        count(Counter::RunInputs, inputs.size());
+        auto const changedAt = changeTime();
+        for (auto input : inputs) {
+            consume(input, changedAt);
+        }
+    }
+
+    /// The table is the interned `STATES`.
+    [[nodiscard]] LightsState save() const override {
+        return {StateTableRegistry::instance().intern(STATES), getLights()};
+    }
+
+    /// Restore the lights, the table must equal `STATES`. Throws `std::invalid_argument` otherwise.
+    void restore(LightsState const& state) override {
+        checkRestore(state, false);
+        if (!std::ranges::equal(state.table->states(), STATES)) {
+            throw std::invalid_argument{"State table does not match StaticLights"};
+        }
+        restoreLights(state.lights);
+    }
+
+   private:
+    /// consume one input changing the lights at `changedAt`, without instrumentation
+    void consume(uint32_t input, uint64_t changedAt = changeTime()) {
+        if (input < STATES.size()) {
+            setLights(STATES[input], changedAt);
+        } else {
+            reportOutOfBounds(input, STATES.size());
+        }
+    }
+};
+
+#endif  // STATICLIGHTS_HPP
@@ -0,0 +1,180 @@
+#include "TableSlot.hpp"
+
+#include <linux/membarrier.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+struct TableSlot::Domain {
+    Domain() noexcept {
+        // readers only announce their epoch with a plain store if expedited membarriers can be used
+        auto const registered = syscall(SYS_membarrier, MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED, 0, 0) == 0;
+        asymmetricFences().store(registered, std::memory_order_relaxed);
+    }
+
+    /// make every running thread of the process execute a full fence, if readers rely on it
+    static void fenceReaders() noexcept {
+        if (asymmetricFences().load(std::memory_order_relaxed)) {
+            syscall(SYS_membarrier, MEMBARRIER_CMD_PRIVATE_EXPEDITED, 0, 0);
+        }
+    }
+
+    /// a table replaced at `epoch`, released once no reader is in a guard entered at `epoch` or before
+    struct Retired {
+        uint64_t epoch;
+        StateTableRegistry::Ref table;
+    };
+
+    std::mutex mutex;
+    /// all reader records, records are never destroyed so that scans never see a dangling record
+    std::vector<std::unique_ptr<Reader>> readers;
+    /// records released by terminated threads, ready to be re-used
+    std::vector<Reader*> released;
+    /// tables waiting until no reader can use them anymore
+    std::vector<Retired> retired;
+    /// retirement counters
+    Stats stats{};
+};
+
+namespace {
+/// hands the reader record of a thread back to the domain when the thread exits
+template <typename Reader, typename Domain>
+struct ReaderReleaser {
+    ReaderReleaser(Reader*& slot, Domain& domain) noexcept : slot{slot}, domain{domain} {}
+
+    ReaderReleaser(ReaderReleaser const&) = delete;
+    ReaderReleaser(ReaderReleaser&&) = delete;
+    ReaderReleaser& operator=(ReaderReleaser const&) = delete;
+    ReaderReleaser& operator=(ReaderReleaser&&) = delete;
+
+    ~ReaderReleaser() {
+        std::lock_guard<std::mutex> const lock{domain.mutex};
+        domain.released.push_back(slot);
+        slot = nullptr;
+    }
+
+    /// the thread-local pointer to the record of the thread
+    Reader*& slot;
+    /// the domain owning the record
+    Domain& domain;
+};
+}  // namespace
+
+TableSlot::Domain& TableSlot::domain() {
+    // intentionally leaked, threads may exit during shutdown
+    static auto* domain = new Domain{};  // NOLINT(cppcoreguidelines-owning-memory)
+    return *domain;
+}
+
+TableSlot::Reader* TableSlot::Reader::acquire() noexcept {
+    auto& readers = domain();
+    Reader* reader{};
+    {
+        std::lock_guard<std::mutex> const lock{readers.mutex};
+        if (!readers.released.empty()) {
+            reader = readers.released.back();
+            readers.released.pop_back();
+        } else {
+            readers.readers.push_back(std::make_unique<Reader>());
+            reader = readers.readers.back().get();
+            // room to release every record without allocating
+            readers.released.reserve(readers.readers.size());
+        }
+    }
+    auto*& local = slot();
+    local = reader;
+    thread_local ReaderReleaser<Reader, Domain> const releaser{local, readers};
+    return reader;
+}
+
+StateTableRegistry::Ref TableSlot::table() const {
+    std::lock_guard<SpinLock> const lock{m_lock};
+    return m_table;
+}
+
+void TableSlot::replace(StateTableRegistry::Ref table) {
+    StateTableRegistry::Ref previous{};
+    {
+        std::lock_guard<SpinLock> const lock{m_lock};
+        m_current.store(table.get(), std::memory_order_seq_cst);
+        previous = std::exchange(m_table, std::move(table));
+    }
+    if (previous == nullptr) {
+        return;
+    }
+    size_t pending{};
+    {
+        // readers which may still use the previous table announced an epoch up to the one before the bump
+        auto const epoch = globalEpoch().fetch_add(1, std::memory_order_seq_cst);
+        auto& retired = domain();
+        std::lock_guard<std::mutex> const lock{retired.mutex};
+        retired.retired.push_back({epoch, std::move(previous)});
+        ++retired.stats.retired;
+        pending = retired.retired.size();
+    }
+    if (pending >= RECLAIM_BATCH) {
+        reclaim();
+    }
+}
+
+void TableSlot::clear() noexcept {
+    StateTableRegistry::Ref previous{};
+    std::lock_guard<SpinLock> const lock{m_lock};
+    m_current.store(nullptr, std::memory_order_seq_cst);
+    // released after unlocking
+    previous = std::exchange(m_table, nullptr);
+}
+
+size_t TableSlot::reclaim() {
+    std::vector<Domain::Retired> released{};
+    size_t remaining{};
+    {
+        auto& readers = domain();
+        std::lock_guard<std::mutex> const lock{readers.mutex};
+        if (readers.retired.empty()) {
+            return 0;
+        }
+        // the epochs announced by readers are visible after the fence, as is the replaced table to later readers
+        Domain::fenceReaders();
+        auto oldest = std::numeric_limits<uint64_t>::max();
+        for (auto const& reader : readers.readers) {
+            auto const epoch = reader->epoch.load(std::memory_order_seq_cst);
+            if (epoch != 0) {
+                oldest = std::min(oldest, epoch);
+            }
+        }
+        // tables retired before the oldest announced epoch cannot be used by any reader
+        auto const unused = std::ranges::partition(readers.retired, [oldest](auto const& entry) {
+            return entry.epoch >= oldest;
+        });
+        std::ranges::move(unused, std::back_inserter(released));
+        readers.retired.erase(unused.begin(), unused.end());
+        readers.stats.reclaimed += released.size();
+        remaining = readers.retired.size();
+    }
+    // the tables are released after unlocking, releasing the last reference takes the lock of the registry
+    return remaining;
+}
+
+void TableSlot::synchronize() {
+    while (reclaim() != 0) {
+        std::this_thread::yield();
+    }
+}
+
+TableSlot::Stats TableSlot::stats() {
+    auto& readers = domain();
+    std::lock_guard<std::mutex> const lock{readers.mutex};
+    return readers.stats;
+}
@@ -0,0 +1,183 @@
+#ifndef TABLESLOT_HPP
+#define TABLESLOT_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#include "SpinLock.hpp"
+#include "StateTable.hpp"
+
+/**
+ * Current state table of one instance, or of a group of instances sharing a timing plan, replaceable while inputs are
+ * processed.
+ *
+ * Readers load the table with `current()` inside a `ReadGuard`, without taking a lock or touching a reference count.
+ * `replace` publishes a new table and retires the old one; the old table is released once every thread that was
+ * inside a read guard when it was replaced has left that guard (epoch-based reclamation). Replacing never waits for
+ * readers and readers never wait for anything, so switching the plan of a whole city does not stall input processing.
+ *
+ * Retired tables are released in batches by later calls of `replace`, which keeps the cost of a fence per batch rather
+ * than per table, or right away by `reclaim()`. `synchronize()` waits until all tables retired so far are released.
+ *
+ * Entering a read guard is a thread-local store. Where the kernel supports `membarrier`, the fence that orders this
+ * store before the loads of the table is issued by the reclaiming thread on behalf of all readers (asymmetric fences),
+ * so that readers do not pay for a full fence per guard. Otherwise readers fall back to a sequentially consistent
+ * store.
+ */
+class TableSlot {
+    struct Reader;
+
+   public:
+    /**
+     * Scope in which the calling thread may use the tables returned by `current()`.
+     *
+     * Guards nest, only the outermost guard of a thread announces the thread as reader. A guard must not be held while
+     * waiting for input: suspending a co-routine or fiber inside a guard keeps retired tables alive until it resumes.
+     */
+    class ReadGuard {
+       public:
+        ReadGuard() noexcept : m_reader{Reader::local()} {
+            if (m_reader.depth++ == 0) {
+                // announce the epoch before loading any table; pairs with the epoch bump in `replace`
+                auto const epoch = globalEpoch().load(std::memory_order_acquire);
+                if (asymmetricFences().load(std::memory_order_relaxed)) {
+                    // `reclaim` makes every thread execute a full fence before it reads the announced epochs
+                    m_reader.epoch.store(epoch, std::memory_order_relaxed);
+                    std::atomic_signal_fence(std::memory_order_seq_cst);
+                } else {
+                    m_reader.epoch.store(epoch, std::memory_order_seq_cst);
+                }
+            }
+        }
+
+        ~ReadGuard() {
+            if (--m_reader.depth == 0) {
+                m_reader.epoch.store(0, std::memory_order_release);
+            }
+        }
+
+        ReadGuard(ReadGuard const&) = delete;
+        ReadGuard(ReadGuard&&) = delete;
+        ReadGuard& operator=(ReadGuard const&) = delete;
+        ReadGuard& operator=(ReadGuard&&) = delete;
+
+       private:
+        /// the record of the thread owning this guard
+        Reader& m_reader;
+    };
+
+    /// Number of retired tables that makes `replace` release the ones no reader can use anymore.
+    static constexpr size_t RECLAIM_BATCH = 64;
+
+    /// Numbers of tables retired by `replace`.
+    struct Stats {
+        /// tables retired so far
+        uint64_t retired;
+        /// retired tables released so far
+        uint64_t reclaimed;
+    };
+
+    /// Create a slot holding `table`, which may be `nullptr`.
+    explicit TableSlot(StateTableRegistry::Ref table = nullptr) noexcept
+        : m_table{std::move(table)}, m_current{m_table.get()} {}
+
+    /// The table must not be in use by any reader.
+    ~TableSlot() = default;
+
+    TableSlot(TableSlot const&) = delete;
+    TableSlot(TableSlot&&) = delete;
+    TableSlot& operator=(TableSlot const&) = delete;
+    TableSlot& operator=(TableSlot&&) = delete;
+
+    /**
+     * Current table, `nullptr` if there is none. Safe to call from any thread.
+     *
+     * The table may only be used inside the `ReadGuard` it was loaded in. Checking against `nullptr` is fine without.
+     */
+    [[nodiscard]] StateTable const* current() const noexcept {
+        return m_current.load(std::memory_order_seq_cst);
+    }
+
+    /// Reference to the current table, keeps the table alive outside of read guards. Thread-safe.
+    [[nodiscard]] StateTableRegistry::Ref table() const;
+
+    /**
+     * Make `table` the current table and retire the previous one, if any. Once `RECLAIM_BATCH` tables are retired,
+     * release those no reader can use anymore.
+     *
+     * Readers entering a read guard from now on see `table`. Never waits for readers. Thread-safe.
+     */
+    void replace(StateTableRegistry::Ref table);
+
+    /**
+     * Drop the current table without retiring it, so that `current()` returns `nullptr`. Only valid while readers that
+     * may still use the table keep it alive by other means, e.g. because it is the current table of another slot.
+     * Thread-safe.
+     */
+    void clear() noexcept;
+
+    /// Release retired tables no reader can use anymore, return the number of tables still retired. Thread-safe.
+    static size_t reclaim();
+
+    /// Wait until all tables retired so far are released. Must not be called inside a read guard.
+    static void synchronize();
+
+    /// Snapshot of the retirement counters of all slots.
+    static Stats stats();
+
+   private:
+    /// per-thread record announcing the epoch the thread entered its outermost guard in
+    struct alignas(64) Reader {
+        /// epoch when the outermost guard was entered, `0` outside of guards
+        std::atomic<uint64_t> epoch{0};
+        /// number of nested guards, only accessed by the owning thread
+        uint32_t depth{0};
+
+        /// record of the calling thread, created on first use
+        static Reader& local() noexcept {
+            auto*& reader = slot();
+            if (reader == nullptr) {
+                reader = acquire();
+            }
+            return *reader;
+        }
+
+        /// the calling thread's record, trivially initialized so that access is a plain thread-local load
+        static Reader*& slot() noexcept {
+            thread_local Reader* reader = nullptr;
+            return reader;
+        }
+
+        /// take a record released by a terminated thread or create a new one, release it when the thread exits
+        static Reader* acquire() noexcept;
+    };
+
+    /// reader records and retired tables of all slots, defined in the source file
+    struct Domain;
+
+    /// the process-wide domain, never destroyed
+    static Domain& domain();
+
+    /// epoch bumped by every `replace`, starts at `1` so that `0` marks threads outside of read guards
+    static std::atomic<uint64_t>& globalEpoch() noexcept {
+        static std::atomic<uint64_t> epoch{1};
+        return epoch;
+    }
+
+    /// true if `reclaim` issues the fences of the readers with `membarrier`, set before the first reader record exists
+    static std::atomic<bool>& asymmetricFences() noexcept {
+        static std::atomic<bool> enabled{false};
+        return enabled;
+    }
+
+    /// protects `m_table`
+    mutable SpinLock m_lock;
+    /// keeps the current table alive
+    StateTableRegistry::Ref m_table;
+    /// the current table, loaded by readers
+    std::atomic<StateTable const*> m_current;
+};
+
+#endif  // TABLESLOT_HPP
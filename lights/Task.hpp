@@ -0,0 +1,217 @@
+#ifndef TASK_HPP
+#define TASK_HPP
+
+#include <cassert>
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+
+#include "FrameAllocation.hpp"
+
+/**
+ * Co-routine producing a value of type `T` (or nothing for `void`), started lazily and awaited by another co-routine.
+ *
+ * A `Task` owns the frame of its co-routine and destroys it when it goes out of scope; destroying a task suspended in
+ * `co_await` of a sub-task destroys the sub-task as well. The co-routine does not run before the task is awaited
+ * (`co_await task`) or started (`start()`).
+ *
+ * Awaiting a task transfers control symmetrically: `await_suspend` returns the handle of the task instead of resuming
+ * it, and the task returns the handle of the awaiting co-routine from its final suspend point. When the compiler turns
+ * these switches into tail calls, which GCC and Clang only do when optimizing, neither switch nests on the native stack
+ * and chains of tasks awaiting sub-tasks run in constant stack space however deep they are. Unoptimized builds nest a
+ * call per switch, so there the depth of a chain is bounded by the stack size.
+ *
+ * Exceptions thrown by the co-routine are rethrown to the awaiting co-routine, or by `result()`. Frames are allocated
+ * as described for `FrameAllocation`, so awaiting a sub-task does not hit the global heap once the pool is warm.
+ */
+template <typename T = void>
+class [[nodiscard]] Task {
+   public:
+    class promise_type;
+
+    /// Handle of the co-routine of a task.
+    using Handle = std::coroutine_handle<promise_type>;
+
+    /// Create an empty task, which does not own a co-routine.
+    Task() = default;
+
+    /// Take ownership of the co-routine `handle`.
+    explicit Task(Handle handle) noexcept : m_handle{handle} {}
+
+    /// Destroy the co-routine, if any.
+    ~Task() {
+        if (m_handle) {
+            m_handle.destroy();
+        }
+    }
+
+    Task(Task const&) = delete;
+    Task& operator=(Task const&) = delete;
+
+    /// Take over the co-routine of `other`, which becomes empty.
+    Task(Task&& other) noexcept : m_handle{std::exchange(other.m_handle, {})} {}
+
+    /// Destroy the co-routine, if any, and take over the co-routine of `other`, which becomes empty.
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            if (m_handle) {
+                m_handle.destroy();
+            }
+            m_handle = std::exchange(other.m_handle, {});
+        }
+        return *this;
+    }
+
+    /// Check whether the task owns a co-routine.
+    [[nodiscard]] bool valid() const noexcept {
+        return static_cast<bool>(m_handle);
+    }
+
+    /// Check whether the co-routine has completed.
+    [[nodiscard]] bool done() const noexcept {
+        return m_handle && m_handle.done();
+    }
+
+    /// Run the co-routine from a caller that is not a co-routine, until it suspends for the first time or completes.
+    void start() {
+        assert(m_handle && !m_handle.done() && "Start of empty or completed task");
+        m_handle.resume();
+    }
+
+    /// Return the value of the completed co-routine, or rethrow its exception. May only be called once.
+    T result() {
+        assert(done() && "Result of incomplete task");
+        return m_handle.promise().result();
+    }
+
+    /// Awaiter returned by `co_await task`, runs the task and yields its value.
+    class Awaiter {
+       public:
+        explicit Awaiter(Handle handle) noexcept : m_handle{handle} {}
+
+        /// return true if the task has completed already
+        [[nodiscard]] bool await_ready() const noexcept {
+            return m_handle.done();
+        }
+
+        /// remember the awaiting co-routine and transfer control to the task
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaitingCoroutine) noexcept {
+            m_handle.promise().m_continuation = awaitingCoroutine;
+            return m_handle;
+        }
+
+        /// return the value of the task, or rethrow its exception
+        T await_resume() {
+            return m_handle.promise().result();
+        }
+
+       private:
+        /// the awaited task
+        Handle m_handle;
+    };
+
+    /// Run the task from a co-routine and yield its value. A task may only be awaited once.
+    Awaiter operator co_await() noexcept {
+        assert(m_handle && "Await of empty task");
+        return Awaiter{m_handle};
+    }
+
+   private:
+    /// Promise parts that do not depend on `T`.
+    class PromiseBase : public FrameAllocation {
+       public:
+        /// Awaiter of the final suspend point, transfers control back to the awaiting co-routine.
+        struct FinalAwaiter {
+            /// always suspend, the frame is destroyed by the owning task
+            [[nodiscard]] static bool await_ready() noexcept {
+                return false;
+            }
+
+            /// return the awaiting co-routine, or return to the caller of `start()` if there is none
+            static std::coroutine_handle<> await_suspend(Handle handle) noexcept {
+                auto const continuation = handle.promise().m_continuation;
+                return continuation ? continuation : std::noop_coroutine();
+            }
+
+            static void await_resume() noexcept {}
+        };
+
+        /// tasks start lazily
+        static std::suspend_always initial_suspend() noexcept {
+            return {};
+        }
+
+        /// resume the awaiting co-routine on completion
+        static FinalAwaiter final_suspend() noexcept {
+            return {};
+        }
+
+        /// keep an exception to rethrow it to the awaiting co-routine
+        void unhandled_exception() noexcept {
+            m_exception = std::current_exception();
+        }
+
+       protected:
+        /// rethrow the exception of the co-routine, if any
+        void rethrow() const {
+            if (m_exception) {
+                std::rethrow_exception(m_exception);
+            }
+        }
+
+       private:
+        friend class Awaiter;
+
+        /// the co-routine awaiting the task, empty if the task was started by `start()`
+        std::coroutine_handle<> m_continuation;
+        /// exception thrown by the co-routine
+        std::exception_ptr m_exception;
+    };
+
+    /// the co-routine
+    Handle m_handle;
+};
+
+/// Promise of a task producing a value.
+template <typename T>
+class Task<T>::promise_type : public PromiseBase {
+   public:
+    Task get_return_object() noexcept {
+        return Task{Handle::from_promise(*this)};
+    }
+
+    /// keep the value for the awaiting co-routine
+    template <typename U>
+    void return_value(U&& value) {
+        m_value.emplace(std::forward<U>(value));
+    }
+
+    /// move the value out, or rethrow the exception of the co-routine
+    T result() {
+        this->rethrow();
+        return *std::move(m_value);
+    }
+
+   private:
+    /// the value, empty until the co-routine returns
+    std::optional<T> m_value;
+};
+
+/// Promise of a task producing nothing.
+template <>
+class Task<void>::promise_type : public PromiseBase {
+   public:
+    Task get_return_object() noexcept {
+        return Task{Handle::from_promise(*this)};
+    }
+
+    void return_void() noexcept {}
+
+    /// rethrow the exception of the co-routine, if any
+    void result() const {
+        rethrow();
+    }
+};
+
+#endif  // TASK_HPP
@@ -1,68 +1,257 @@
 #include "ThreadLights.hpp"
 
+#include <atomic>
 #include <cstdint>
-#include <iostream>
 #include <mutex>
+#include <span>
+#include <utility>
 #include <vector>
 
+#include "StateTable.hpp"
+#include "TableSlot.hpp"
+
 void ThreadLights::interrupt() {
-    if (!m_interrupt) {
+    {
         std::lock_guard<std::mutex> const lock{m_mutex};
 
         m_interrupt = true;
     }
+    m_notEmpty.notify_all();
+    m_notFull.notify_all();
+    if (m_lockFree) {
+        // wake up producers parked on a full queue, they see the interrupt once they wake up
+        m_drained.fetch_add(1, std::memory_order_release);
+        m_drained.notify_all();
+        wakeLockFree();
+    }
 }
 
 uint32_t ThreadLights::get() {
-    while (true) {
-        std::lock_guard<std::mutex> const lock{m_mutex};
+    // process the batch taken from the queue before touching the queue again
+    if (m_batchNext < m_batch.size()) {
+        return m_batch[m_batchNext++];
+    }
+    m_batch.clear();
+    m_batchNext = 0;
 
-        // if a value is available, process it
-        if (m_input.has_value()) {
-            auto input = m_input.value();
-            m_input.reset();
-            return input;
+    if (m_lockFree) {
+        takeLockFree();
+        return m_batch[m_batchNext++];
+    }
+
+    {
+        std::unique_lock<std::mutex> lock{m_mutex};
+
+        // park until a value is available, interrupted or restored
+        if (m_queue.empty() && !m_interrupt && !m_restore) {
+            countShared(Counter::QueueWaits);
         }
+        m_notEmpty.wait(lock, [this]() { return !m_queue.empty() || m_interrupt || m_restore; });
 
-        // if no value and interrupted, throw
-        if (m_interrupt) {
+        if (m_restore) {
+            m_restore = false;
+            throw Restored{};
+        }
+        // if no value and interrupted, throw; queued values are processed first
+        if (m_queue.empty()) {
             throw Interrupted{};
         }
+
+        m_queue.popAll(m_batch);
     }
+    m_notFull.notify_all();
+    return m_batch[m_batchNext++];
 }
 
-void ThreadLights::processInput(uint32_t input) {
+void ThreadLights::takeLockFree() {
     while (true) {
-        std::lock_guard<std::mutex> const lock{m_mutex};
+        // an interrupt observed before finding the queue empty means all inputs provided before it were taken
+        auto const interrupted = m_interrupt.load(std::memory_order_acquire);
+        if (m_restore.load(std::memory_order_acquire)) {
+            std::lock_guard<std::mutex> const lock{m_mutex};
+            m_restore = false;
+            throw Restored{};
+        }
+        if (m_lockFree->popAll(m_batch) > 0) {
+            m_drained.fetch_add(1, std::memory_order_release);
+            m_drained.notify_all();
+            return;
+        }
+        if (interrupted) {
+            throw Interrupted{};
+        }
 
-        if (!m_input.has_value()) {
-            m_input = {input};
+        // announce that the worker is about to park, then check again; a producer either sees the announcement or
+        // published its input before the check (both sides use sequentially consistent fences)
+        m_sleeping.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!m_lockFree->empty() || m_interrupt.load(std::memory_order_relaxed) ||
+            m_restore.load(std::memory_order_relaxed)) {
+            m_sleeping.store(false, std::memory_order_relaxed);
+            continue;
+        }
+        countShared(Counter::QueueWaits);
+        m_sleeping.wait(true, std::memory_order_acquire);
+    }
+}
+
+void ThreadLights::pushLockFree(std::span<uint32_t const> inputs) {
+    while (!inputs.empty()) {
+        // load the epoch before checking the interrupt, `interrupt` sets the flag before bumping the epoch
+        auto const epoch = m_drained.load(std::memory_order_acquire);
+        if (m_interrupt.load(std::memory_order_acquire)) {
+            return;
+        }
+        auto const pushed = m_lockFree->tryPush(inputs);
+        if (pushed > 0) {
+            inputs = inputs.subspan(pushed);
+            wakeLockFree();
+            continue;
+        }
+        // park until the worker thread took inputs from the queue or the lights are interrupted
+        countShared(Counter::QueueWaits);
+        m_drained.wait(epoch, std::memory_order_acquire);
+    }
+}
+
+void ThreadLights::wakeLockFree() noexcept {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_sleeping.load(std::memory_order_relaxed) && m_sleeping.exchange(false, std::memory_order_acq_rel)) {
+        m_sleeping.notify_one();
+    }
+}
+
+void ThreadLights::processInput(uint32_t input) {
+    LatencyProbe const probe{*this};
+    if (m_lockFree) {
+        pushLockFree(std::span<uint32_t const>{&input, 1});
+        return;
+    }
+    {
+        std::unique_lock<std::mutex> lock{m_mutex};
+
+        // park until there is space in the queue or interrupted
+        if (m_queue.full() && !m_interrupt) {
+            countShared(Counter::QueueWaits);
+        }
+        m_notFull.wait(lock, [this]() { return !m_queue.full() || m_interrupt; });
+
+        if (m_interrupt) {
             return;
         }
+
+        m_queue.push(input);
+    }
+    m_notEmpty.notify_one();
+}
+
+void ThreadLights::processInputs(std::span<uint32_t const> inputs) {
+    if (m_lockFree) {
+        pushLockFree(inputs);
+        return;
+    }
+    while (!inputs.empty()) {
+        {
+            std::unique_lock<std::mutex> lock{m_mutex};
+
+            // park until there is space in the queue or interrupted
+            if (m_queue.full() && !m_interrupt) {
+                countShared(Counter::QueueWaits);
+            }
+            m_notFull.wait(lock, [this]() { return !m_queue.full() || m_interrupt; });
+
+            if (m_interrupt) {
+                return;
+            }
+
+            inputs = inputs.subspan(m_queue.push(inputs));
+        }
+        m_notEmpty.notify_one();
+    }
+}
+
+bool ThreadLights::tryProcessInput(uint32_t input) {
+    if (m_lockFree) {
+        if (m_interrupt.load(std::memory_order_acquire) || !m_lockFree->tryPush(input)) {
+            return false;
+        }
+        wakeLockFree();
+        return true;
+    }
+    {
+        std::lock_guard<std::mutex> const lock{m_mutex};
+
+        if (m_queue.full() || m_interrupt) {
+            return false;
+        }
+
+        m_queue.push(input);
+    }
+    m_notEmpty.notify_one();
+    return true;
+}
+
+LightsState ThreadLights::save() const {
+    std::lock_guard<std::mutex> const lock{m_mutex};
+    return {tableRef(), getLights()};
+}
+
+void ThreadLights::restore(LightsState const& state) {
+    {
+        std::lock_guard<std::mutex> const lock{m_mutex};
+        checkRestore(state, hasTable());
+        initTable(state.table);
+        m_restore = true;
+        restoreLights(state.lights);
+    }
+    m_notEmpty.notify_one();
+    if (m_lockFree) {
+        wakeLockFree();
     }
 }
 
 void ThreadLights::run() {
+    try {
+        init();
+
+        // RUN, the table is read for every input so that it can be replaced
+        while (true) {
+            auto input = get();
+            count(Counter::RunInputs);
+            TableSlot::ReadGuard const guard{};
+            auto const& states = table();
+            if (input < states.size()) {
+                setLights(states[input]);
+            } else {
+                reportOutOfBounds(input, states.size());
+            }
+        }
+    } catch (Interrupted) {
+        record(TransitionEvent::Kind::Interrupted, 0, 0);
+    }
+}
+
+void ThreadLights::init() {
     try {
         // INIT, part 0
         auto len = get();
+        count(Counter::InitInputs);
         std::vector<uint32_t> lightsVec{};
         lightsVec.reserve(len);
         // INIT, part 1
         for (int i = 0; i < len; ++i) {
             lightsVec.push_back(get());
+            count(Counter::InitInputs);
         }
+        auto table = StateTableRegistry::instance().intern(lightsVec);
 
-        // RUN
-        while (true) {
-            auto input = get();
-            if (input < lightsVec.size()) {
-                setLights(lightsVec[input]);
-            } else {
-                std::cout << "Out of bounds: " << input << " >= " << lightsVec.size() << "\n";
-            }
+        std::lock_guard<std::mutex> const lock{m_mutex};
+        if (!m_restore) {
+            initTable(std::move(table));
         }
-    } catch (Interrupted) {
-        std::cout << "Thread interrupted.\n";
+        // a restore racing with the end of INIT wins
+        m_restore = false;
+    } catch (Restored) {
+        // the table was set by `restore`
     }
 }
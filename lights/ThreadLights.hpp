@@ -1,18 +1,55 @@
 #ifndef THREADLIGHTS_HPP
 #define THREADLIGHTS_HPP
 
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
 #include <cstdint>
+#include <memory>
 #include <mutex>
-#include <optional>
+#include <span>
 #include <thread>
+#include <vector>
 
 #include "Lights.hpp"
+#include "MpscQueue.hpp"
+#include "RingBuffer.hpp"
+#include "StateTable.hpp"
+#include "TableSlot.hpp"
 
-class ThreadLights : public Lights {
+/**
+ * Implementation of lights using a thread.
+ *
+ * Inputs are handed over to the worker thread through a bounded queue. The worker thread blocks on a condition
+ * variable while the queue is empty and takes all queued inputs at once when it wakes up, producers block while the
+ * queue is full. Interrupting the lights (done by the destructor) wakes up everybody at once. Inputs still queued at
+ * that time are processed before the worker thread terminates.
+ *
+ * With `Queue::LockFree`, inputs are handed over through an `MpscQueue` instead, so that many producer threads can feed
+ * one instance without serializing on the mutex. Producers only touch the mutex-free queue and wake the worker thread
+ * if it announced that it is about to sleep; the worker takes everything published per wakeup.
+ */
+class ThreadLights final : public Lights {
    public:
-    void processInput(uint32_t input) override;
+    /// Default number of inputs that can be queued before producers block.
+    static constexpr size_t DEFAULT_CAPACITY = 64;
+
+    /// How inputs are handed over to the worker thread.
+    enum class Queue {
+        /// ring buffer protected by a mutex, producers and the worker thread park on condition variables
+        Locked,
+        /// lock-free multi-producer queue, the worker thread parks on an atomic flag
+        LockFree,
+    };
 
-    ThreadLights() : m_thread{[this]() { this->run(); }} {}
+    /**
+     * Create lights with an input queue of given capacity and kind, and start the worker thread. The capacity of a
+     * lock-free queue is rounded up to a power of two.
+     */
+    explicit ThreadLights(size_t capacity = DEFAULT_CAPACITY, Queue queue = Queue::Locked)
+        : m_queue{queue == Queue::Locked ? capacity : 1},
+          m_lockFree{queue == Queue::LockFree ? std::make_unique<MpscQueue<uint32_t>>(capacity) : nullptr},
+          m_thread{[this]() { this->run(); }} {}
 
     ~ThreadLights() override {
         interrupt();
@@ -24,17 +61,71 @@ class ThreadLights : public Lights {
     ThreadLights& operator=(ThreadLights const&) = delete;
     ThreadLights& operator=(ThreadLights&&) = delete;
 
+    /**
+     * Provide an input, block while the input queue is full.
+     *
+     * Inputs provided after the lights are interrupted are discarded.
+     */
+    void processInput(uint32_t input) override;
+
+    /**
+     * Provide several inputs, pushed to the queue with as few lock round-trips as possible. Blocks while the queue is
+     * full. Inputs provided after the lights are interrupted are discarded.
+     */
+    void processInputs(std::span<uint32_t const> inputs) override;
+
+    /**
+     * Provide an input without blocking.
+     *
+     * Return `false` if the input queue is full or the lights are interrupted, the input is discarded in that case.
+     */
+    bool tryProcessInput(uint32_t input);
+
+    [[nodiscard]] LightsState save() const override;
+
+    /// Restore, the worker thread abandons INIT. Inputs provided afterwards are RUN inputs.
+    void restore(LightsState const& state) override;
+
    private:
     class Interrupted {};
+    /// thrown by `get` to abandon INIT when the lights are restored
+    class Restored {};
 
     void run();
+    /// run INIT, unless the lights are restored
+    void init();
     void interrupt();
     uint32_t get();
+    /// take the next batch from the lock-free queue into `m_batch`, park while it is empty
+    void takeLockFree();
+    /// push `inputs` to the lock-free queue, park while it is full
+    void pushLockFree(std::span<uint32_t const> inputs);
+    /// wake up the worker thread parked in `takeLockFree`, if it is
+    void wakeLockFree() noexcept;
 
-    std::mutex m_mutex{};
-    std::optional<uint32_t> m_input{};
+    mutable std::mutex m_mutex{};
+    /// signaled when an input is queued or the lights are interrupted
+    std::condition_variable m_notEmpty{};
+    /// signaled when an input is taken from the queue or the lights are interrupted
+    std::condition_variable m_notFull{};
+    /// the queue in `Queue::Locked` mode, a single unused slot otherwise
+    RingBuffer<uint32_t> m_queue;
+    /// the queue in `Queue::LockFree` mode, `nullptr` otherwise
+    std::unique_ptr<MpscQueue<uint32_t>> m_lockFree;
+    /// true while the worker thread is parked or about to park on the lock-free queue
+    std::atomic<bool> m_sleeping{false};
+    /// bumped whenever the worker thread took inputs from the lock-free queue, producers park on it while it is full
+    std::atomic<uint32_t> m_drained{0};
+    /// written with the mutex held, read without it in `Queue::LockFree` mode
+    std::atomic<bool> m_interrupt{false};
+    /// set by `restore` to make `get` throw `Restored`
+    std::atomic<bool> m_restore{false};
+    /// inputs taken from the queue by the worker thread, only accessed by the worker thread
+    std::vector<uint32_t> m_batch;
+    /// index of next input to process in `m_batch`
+    size_t m_batchNext{};
+    /// the worker thread, declared last so that it starts after all other members are initialized
     std::thread m_thread;
-    bool m_interrupt{false};
 };
 
 #endif  // THREADLIGHTS_HPP
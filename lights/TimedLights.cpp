@@ -0,0 +1,205 @@
+#include "TimedLights.hpp"
+
+#include <algorithm>
+#include <array>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include "StateTable.hpp"
+#include "TableSlot.hpp"
+
+TimedLights::TimedLights(LightsExecutor& executor, Duration phase, Duration offset,
+                         std::pmr::memory_resource* frameResource)
+    : m_executor{executor},
+      m_phase{phase},
+      m_offset{offset},
+      m_values{frameResource != nullptr ? frameResource : &FramePool::instance()} {
+    m_timer.callback = &TimedLights::expire;
+    m_timer.context = this;
+    run(frameResource != nullptr ? frameResource : &FramePool::instance());
+}
+
+TimedLights::~TimedLights() {
+    m_executor.timers().cancel(m_timer);
+    if (m_scheduled) {
+        m_executor.cancel(m_coroutine);
+    }
+    if (m_coroutine) {
+        m_coroutine.destroy();
+    }
+}
+
+void TimedLights::restore(LightsState const& state) {
+    checkRestore(state, hasTable());
+    if (!m_waiting) {
+        throw std::logic_error{"Cannot restore lights while inputs are pending"};
+    }
+    initTable(state.table);
+    restoreLights(state.lights);
+    m_executor.timers().cancel(m_timer);
+    m_coroutine.destroy();
+    m_coroutine = {};
+    m_waiting = false;
+    run(m_values.get_allocator().resource());
+}
+
+void TimedLights::processInput(uint32_t input) {
+    LatencyProbe const probe{*this};
+    processInputs(std::span<uint32_t const>{&input, 1});
+}
+
+void TimedLights::processInputs(std::span<uint32_t const> inputs) {
+    if (inputs.empty()) {
+        return;
+    }
+    if (!m_waiting) {
+        // co-routine is sleeping or scheduled, it will consume the values once it waits for input again
+        m_values.insert(m_values.end(), inputs.begin(), inputs.end());
+        return;
+    }
+    // co-routine is waiting, so there are no values queued: hand over the first value directly
+    m_value = inputs.front();
+    m_values.insert(m_values.end(), inputs.begin() + 1, inputs.end());
+    m_waiting = false;
+    m_resumed = true;
+    m_scheduled = true;
+    m_executor.timers().cancel(m_timer);
+    m_executor.schedule(m_coroutine);
+}
+
+bool TimedLights::take() noexcept {
+    if (m_next == m_values.size()) {
+        return false;
+    }
+    m_value = m_values[m_next++];
+    if (m_next == m_values.size()) {
+        // all values consumed, re-use storage
+        m_values.clear();
+        m_next = 0;
+    }
+    return true;
+}
+
+void TimedLights::expire(Timer& timer) {
+    auto& self = *static_cast<TimedLights*>(timer.context);
+    self.m_waiting = false;
+    self.m_timedOut = true;
+    self.m_scheduled = true;
+    self.m_executor.schedule(self.m_coroutine);
+}
+
+void TimedLights::InputOrTimeout::await_suspend(std::coroutine_handle<> awaitingCoroutine) noexcept {
+    m_owner.m_coroutine = awaitingCoroutine;
+    m_owner.m_waiting = true;
+    if (m_ticks > 0) {
+        m_owner.m_executor.timers().schedule(m_owner.m_timer, m_ticks);
+    }
+}
+
+std::optional<uint32_t> TimedLights::InputOrTimeout::await_resume() const noexcept {
+    m_owner.m_scheduled = false;
+    if (m_owner.m_timedOut) {
+        m_owner.m_timedOut = false;
+        m_owner.count(Counter::Timeouts);
+        return std::nullopt;
+    }
+    if (m_owner.m_resumed) {
+        m_owner.m_resumed = false;
+        m_owner.count(Counter::Resumes);
+    }
+    return m_owner.m_value;
+}
+
+void TimedLights::Sleep::await_suspend(std::coroutine_handle<> awaitingCoroutine) noexcept {
+    m_owner.m_coroutine = awaitingCoroutine;
+    m_owner.m_executor.timers().schedule(m_owner.m_timer, m_ticks);
+}
+
+// NOLINTBEGIN: readability-static-accessed-through-instance (clang tidy seems to be distracted by co-routines)
+// GCC warns that the frame allocated by the placement `operator new` of `FrameAllocation` is freed by the usual
+// `operator delete`, but that is how co-routine frames are freed by the standard ([dcl.fct.def.coroutine])
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+/**
+ * Same INIT as `CoRoutineLights::run`, skipped if restored. In RUN, the state is kept in a local variable (active) as
+ * well, since timeouts advance it without an input. The table is read whenever the co-routine resumes, so a replaced
+ * plan takes effect at the next timeout or input.
+ */
+TimedLights::Task TimedLights::run(std::pmr::memory_resource* frameResource) noexcept {
+    size_t active = 0;
+    if (!hasTable()) {
+        // INIT, part 0
+        auto len = *co_await input();
+        count(Counter::InitInputs);
+#if LIGHTS_INLINE_STATES > 0
+        std::array<uint32_t, LIGHTS_INLINE_STATES> tableBuffer;  // NOLINT(cppcoreguidelines-pro-type-member-init)
+        std::pmr::monotonic_buffer_resource tableResource{tableBuffer.data(), sizeof(tableBuffer), frameResource};
+        std::pmr::vector<uint32_t> lightsVec{&tableResource};
+#else
+        std::pmr::vector<uint32_t> lightsVec{frameResource};
+#endif
+        lightsVec.reserve(len);
+        // INIT, part 1
+        for (uint32_t i = 0; i < len; ++i) {
+            lightsVec.push_back(*co_await input());
+            count(Counter::InitInputs);
+        }
+        initTable(StateTableRegistry::instance().intern(lightsVec));
+
+        // RUN
+        co_await sleepFor(m_offset);
+        TableSlot::ReadGuard const guard{};
+        auto const& states = table();
+        if (states.size() > 0) {
+            setLights(states[active]);
+        }
+    } else {
+        // restored: continue with the state showing the current lights
+        TableSlot::ReadGuard const guard{};
+        auto const states = table().states();
+        auto const restored = std::ranges::find(states, getLights());
+        active = restored != states.end() ? static_cast<size_t>(restored - states.begin()) : 0;
+    }
+    auto phase = Duration::zero();
+    {
+        TableSlot::ReadGuard const guard{};
+        phase = table().size() == 0 ? Duration::zero() : m_phase;
+    }
+    while (true) {
+        auto next = co_await inputOrTimeout(phase);
+        // the guard ends before the next `co_await`
+        TableSlot::ReadGuard const guard{};
+        auto const states = table().states();
+        phase = states.empty() ? Duration::zero() : m_phase;
+        if (!next) {
+            if (states.empty()) {
+                // the plan was replaced by one without states
+                continue;
+            }
+            // phase is over, next state of the plan
+            active = (active + 1) % states.size();
+            setLights(states[active]);
+            continue;
+        }
+        count(Counter::RunInputs);
+        if (*next < states.size()) {
+            active = *next;
+            setLights(states[active]);
+        } else {
+            reportOutOfBounds(*next, states.size());
+        }
+    }
+}
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+// NOLINTEND: readability-static-accessed-through-instance
@@ -0,0 +1,191 @@
+#ifndef TIMEDLIGHTS_HPP
+#define TIMEDLIGHTS_HPP
+
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "FramePool.hpp"
+#include "FrameTask.hpp"
+#include "Lights.hpp"
+#include "LightsExecutor.hpp"
+#include "StateTable.hpp"
+#include "TimingWheel.hpp"
+
+/**
+ * Implementation of lights using a co-routine that switches its lights on timeouts, like a real signal controller.
+ *
+ * INIT is the same as for the other implementations. After INIT, the co-routine waits for the offset passed to the
+ * constructor (`co_await sleepFor(offset)`), switches to state 0 and then cycles through the states, each active for
+ * one phase. Every RUN input forces the state it selects and restarts the phase (`co_await inputOrTimeout(phase)`),
+ * out of bounds inputs are reported and restart the phase as well. Without states, there is no timeout.
+ *
+ * The co-routine is driven by a `LightsExecutor`: timers are scheduled on the executor's timing wheel and the
+ * co-routine is resumed from the executor's ready-queue. There is one timer per instance, embedded in the instance, so
+ * millions of instances with pending timers cost no allocations beyond the instances themselves.
+ *
+ * This type is not thread-safe. Inputs must be provided from the thread running the executor. Instances must be
+ * destroyed before the executor, and not by their own co-routine. Destroying an instance whose co-routine is on the
+ * executor's ready-queue removes it from there.
+ */
+class TimedLights final : public Lights {
+   public:
+    /// Duration of phases and offsets.
+    using Duration = LightsExecutor::Duration;
+
+    /**
+     * Create a new instance driven by `executor` and start its internal co-routine.
+     *
+     * Each state is active for `phase`, rounded up to whole ticks of the executor; the first state is activated
+     * `offset` after INIT. The co-routine frame, the state table and the input queue are allocated from
+     * `frameResource`, or from `FramePool::instance()` if it is `nullptr`.
+     */
+    TimedLights(LightsExecutor& executor, Duration phase, Duration offset = Duration::zero(),
+                std::pmr::memory_resource* frameResource = nullptr);
+
+    /// Cancel the pending timer, if any, remove the co-routine from the ready-queue, if scheduled, and destroy it.
+    ~TimedLights() override;
+
+    /// Deleted copy constructor, type is not copyable.
+    TimedLights(TimedLights const&) = delete;
+
+    /// Deleted copy assignment, type is not copyable.
+    TimedLights& operator=(TimedLights const&) = delete;
+
+    /// Deleted move constructor, type is not movable. Running co-routine and timer would refer to original object.
+    TimedLights(TimedLights&&) = delete;
+
+    /// Deleted move assignment, type is not movable. Running co-routine and timer would refer to original object.
+    TimedLights& operator=(TimedLights&&) = delete;
+
+    /// Provide an input. The input is queued if the co-routine is not waiting for input.
+    void processInput(uint32_t input) override;
+
+    /// Provide several inputs at once. The co-routine is scheduled at most once to consume all of them.
+    void processInputs(std::span<uint32_t const> inputs) override;
+
+    /// Check whether the co-routine is idle, i.e., waiting for input or a timeout with no inputs queued.
+    [[nodiscard]] bool ready() const noexcept {
+        return m_waiting;
+    }
+
+    [[nodiscard]] LightsState save() const override {
+        return {tableRef(), getLights()};
+    }
+
+    /**
+     * Restore, the co-routine is restarted in RUN and continues the phase plan with the state showing the restored
+     * lights, without waiting for the offset. Throws `std::logic_error` if the co-routine is not idle.
+     */
+    void restore(LightsState const& state) override;
+
+   private:
+    /// Return object created by invoking run method
+    using Task = FrameTask;
+
+    /// Awaiter resuming with the next input, or with nothing if the timeout expires first.
+    class InputOrTimeout {
+       public:
+        /// Constructor, time out after `ticks` ticks, never if `ticks` is 0.
+        InputOrTimeout(TimedLights& owner, uint64_t ticks) noexcept : m_owner{owner}, m_ticks{ticks} {}
+
+        /// return true if a value is queued, the co-routine does not suspend in that case
+        [[nodiscard]] bool await_ready() const noexcept {
+            return m_owner.take();
+        }
+
+        /// suspend until an input is provided or the timeout expires
+        void await_suspend(std::coroutine_handle<> awaitingCoroutine) noexcept;
+
+        /// return the input, or nothing on timeout
+        [[nodiscard]] std::optional<uint32_t> await_resume() const noexcept;
+
+       private:
+        /// the lights awaiting input
+        TimedLights& m_owner;
+        /// ticks until timeout, 0 for none
+        uint64_t m_ticks;
+    };
+
+    /// Awaiter resuming after a number of ticks, inputs are queued in the meantime.
+    class Sleep {
+       public:
+        /// Constructor, sleep for `ticks` ticks.
+        Sleep(TimedLights& owner, uint64_t ticks) noexcept : m_owner{owner}, m_ticks{ticks} {}
+
+        /// return true if there is nothing to wait for
+        [[nodiscard]] bool await_ready() const noexcept {
+            return m_ticks == 0;
+        }
+
+        /// suspend until the timer expires
+        void await_suspend(std::coroutine_handle<> awaitingCoroutine) noexcept;
+
+        /// nothing to return
+        void await_resume() const noexcept {
+            m_owner.m_scheduled = false;
+            m_owner.m_timedOut = false;
+        }
+
+       private:
+        /// the sleeping lights
+        TimedLights& m_owner;
+        /// ticks to sleep
+        uint64_t m_ticks;
+    };
+
+    /// Start the co-routine, proceed as inputs are provided and timers expire; allocate from `frameResource`
+    Task run(std::pmr::memory_resource* frameResource) noexcept;
+
+    /// Wait for the next input, without timeout.
+    [[nodiscard]] InputOrTimeout input() noexcept {
+        return {*this, 0};
+    }
+
+    /// Wait for the next input, but at most `timeout`; wait without timeout if `timeout` is not positive.
+    [[nodiscard]] InputOrTimeout inputOrTimeout(Duration timeout) noexcept {
+        return {*this, m_executor.ticks(timeout)};
+    }
+
+    /// Wait for `duration`, queueing inputs in the meantime.
+    [[nodiscard]] Sleep sleepFor(Duration duration) noexcept {
+        return {*this, m_executor.ticks(duration)};
+    }
+
+    /// Take the next queued value into `m_value`, return false if there is none.
+    bool take() noexcept;
+
+    /// Timer callback, resume the co-routine.
+    static void expire(Timer& timer);
+
+    /// the executor resuming the co-routine
+    LightsExecutor& m_executor;
+    /// duration each state is active
+    Duration m_phase;
+    /// delay between INIT and the activation of the first state
+    Duration m_offset;
+    /// the timer of the awaiter the co-routine is suspended on
+    Timer m_timer{};
+    /// the handle of the suspended co-routine, kept to destroy the co-routine frame
+    std::coroutine_handle<> m_coroutine;
+    /// true if the co-routine is suspended waiting for a value
+    bool m_waiting{false};
+    /// true while the co-routine is on the executor's ready-queue
+    bool m_scheduled{false};
+    /// true if the co-routine was handed a value while waiting and has not consumed it yet
+    bool m_resumed{false};
+    /// true if the timer expired and the co-routine has not observed it yet
+    bool m_timedOut{false};
+    /// the value to return on resume
+    uint32_t m_value{};
+    /// queued values, storage is re-used once all values are consumed
+    std::pmr::vector<uint32_t> m_values;
+    /// index of next value to consume
+    size_t m_next{};
+};
+
+#endif  // TIMEDLIGHTS_HPP
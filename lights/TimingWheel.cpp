@@ -0,0 +1,115 @@
+#include "TimingWheel.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace {
+/// number of timers to prefetch ahead when processing a batch
+constexpr size_t PREFETCH = 8;
+}  // namespace
+
+TimingWheel::~TimingWheel() {
+    for (auto& slot : m_slots) {
+        for (auto* timer : slot) {
+            timer->slot = Timer::NONE;
+        }
+    }
+    for (auto* timer : m_due) {
+        timer->slot = Timer::NONE;
+    }
+}
+
+void TimingWheel::schedule(Timer& timer, uint64_t ticks) {
+    cancel(timer);
+    timer.expiry = m_now + std::max<uint64_t>(ticks, 1);
+    insert(timer);
+    ++m_size;
+}
+
+void TimingWheel::cancel(Timer& timer) noexcept {
+    if (timer.scheduled()) {
+        remove(timers(timer.slot), timer);
+        --m_size;
+    }
+}
+
+size_t TimingWheel::tick() {
+    ++m_now;
+    // cascade from the top, so that timers moved down are cascaded further if their slot is due as well
+    for (auto level = LEVELS - 1; level > 0; --level) {
+        auto const span = uint64_t{1} << (SLOT_BITS * level);
+        if ((m_now & (span - 1)) == 0) {
+            cascade(level);
+        }
+    }
+
+    // take the due slot out of the wheel, callbacks may cancel timers in it and schedule new ones into the wheel
+    std::swap(m_due, m_slots[m_now & (SLOTS - 1)]);
+    for (auto* timer : m_due) {
+        timer->slot = DUE;
+    }
+    size_t expired = 0;
+    while (!m_due.empty()) {
+        if (m_due.size() > PREFETCH) {
+            __builtin_prefetch(m_due[m_due.size() - 1 - PREFETCH]);
+        }
+        auto& timer = *m_due.back();
+        m_due.pop_back();
+        timer.slot = Timer::NONE;
+        --m_size;
+        ++expired;
+        timer.callback(timer);
+    }
+    return expired;
+}
+
+size_t TimingWheel::advance(uint64_t ticks) {
+    size_t expired = 0;
+    for (uint64_t i = 0; i < ticks; ++i) {
+        if (m_size == 0) {
+            // nothing to expire or cascade
+            m_now += ticks - i;
+            break;
+        }
+        expired += tick();
+    }
+    return expired;
+}
+
+void TimingWheel::insert(Timer& timer) {
+    auto const delta = timer.expiry > m_now ? timer.expiry - m_now : 0;
+    size_t level = 0;
+    while (level + 1 < LEVELS && delta >= (uint64_t{1} << (SLOT_BITS * (level + 1)))) {
+        ++level;
+    }
+    // timers beyond the range of the top level wait in the slot cascaded last before their expiry
+    auto const limit = m_now + (uint64_t{1} << (SLOT_BITS * LEVELS)) - 1;
+    auto const expiry = std::min(std::max(timer.expiry, m_now), limit);
+    auto const slot = static_cast<uint32_t>(level * SLOTS + ((expiry >> (SLOT_BITS * level)) & (SLOTS - 1)));
+    auto& timers = m_slots[slot];
+    timers.push_back(&timer);
+    timer.slot = slot;
+    timer.index = static_cast<uint32_t>(timers.size() - 1);
+}
+
+void TimingWheel::remove(std::vector<Timer*>& slot, Timer& timer) noexcept {
+    auto* last = slot.back();
+    slot[timer.index] = last;
+    last->index = timer.index;
+    slot.pop_back();
+    timer.slot = Timer::NONE;
+}
+
+void TimingWheel::cascade(size_t level) {
+    std::swap(m_cascade, m_slots[level * SLOTS + ((m_now >> (SLOT_BITS * level)) & (SLOTS - 1))]);
+    for (size_t i = 0; i < m_cascade.size(); ++i) {
+        if (i + PREFETCH < m_cascade.size()) {
+            __builtin_prefetch(m_cascade[i + PREFETCH]);
+        }
+        insert(*m_cascade[i]);
+    }
+    m_cascade.clear();
+}
@@ -0,0 +1,127 @@
+#ifndef TIMINGWHEEL_HPP
+#define TIMINGWHEEL_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+/**
+ * Timer to be scheduled on a `TimingWheel`.
+ *
+ * The owner of a timer keeps it alive while it is scheduled; the wheel only stores pointers to timers. When the timer
+ * expires, the wheel calls `callback` with the timer.
+ */
+struct Timer {
+    /// Function called when the timer expires.
+    using Callback = void (*)(Timer& timer);
+
+    /// Value of `slot` while the timer is not scheduled.
+    static constexpr uint32_t NONE = std::numeric_limits<uint32_t>::max();
+
+    /// called on expiry, must be set before the timer is scheduled
+    Callback callback{};
+    /// owner defined data, e.g. the object to notify
+    void* context{};
+    /// tick at which the timer expires
+    uint64_t expiry{};
+    /// slot of the wheel the timer is in, `NONE` if the timer is not scheduled
+    uint32_t slot{NONE};
+    /// position of the timer in its slot
+    uint32_t index{};
+
+    /// Return true if the timer is scheduled.
+    [[nodiscard]] bool scheduled() const noexcept {
+        return slot != NONE;
+    }
+};
+
+/**
+ * Hierarchical timing wheel.
+ *
+ * Time advances in ticks. Each level has `SLOTS` slots, a slot of level `l` spans `SLOTS^l` ticks, so the levels
+ * together cover `SLOTS^LEVELS` ticks. A timer is put into the lowest level that covers its expiry. Whenever a level
+ * wraps around, the next slot of the level above is cascaded, i.e., its timers are redistributed to lower levels.
+ * Timers further in the future than the top level covers wait in the top level and are cascaded repeatedly.
+ *
+ * Each slot is an array of pointers to its timers, and every timer knows its position, so scheduling and cancelling a
+ * timer take constant time. Advancing by one tick takes constant time plus the time to expire and cascade the timers
+ * due; these are processed as one batch per slot, prefetching the timers ahead, so that a batch is not a chain of
+ * cache misses as with a linked list. Slots keep their capacity, so the wheel stops allocating once it has seen its
+ * peak load. This type is not thread-safe.
+ */
+class TimingWheel {
+   public:
+    /// Number of bits of a tick index per level.
+    static constexpr unsigned SLOT_BITS = 6;
+    /// Number of slots per level.
+    static constexpr size_t SLOTS = size_t{1} << SLOT_BITS;
+    /// Number of levels.
+    static constexpr size_t LEVELS = 5;
+
+    TimingWheel() = default;
+
+    /// Unschedule all timers still scheduled, without calling them.
+    ~TimingWheel();
+
+    TimingWheel(TimingWheel const&) = delete;
+    TimingWheel(TimingWheel&&) = delete;
+    TimingWheel& operator=(TimingWheel const&) = delete;
+    TimingWheel& operator=(TimingWheel&&) = delete;
+
+    /// Current tick.
+    [[nodiscard]] uint64_t now() const noexcept {
+        return m_now;
+    }
+
+    /// Number of scheduled timers.
+    [[nodiscard]] size_t size() const noexcept {
+        return m_size;
+    }
+
+    /// Schedule `timer` to expire `ticks` ticks from now, at least one. Reschedules the timer if it is scheduled.
+    void schedule(Timer& timer, uint64_t ticks);
+
+    /// Cancel `timer`, nothing happens if it is not scheduled.
+    void cancel(Timer& timer) noexcept;
+
+    /**
+     * Advance by one tick and expire the timers due.
+     *
+     * Callbacks may schedule and cancel timers, timers scheduled by a callback expire at a later tick. Return the
+     * number of expired timers.
+     */
+    size_t tick();
+
+    /// Advance by `ticks` ticks, return the number of expired timers. Empty stretches are skipped at once.
+    size_t advance(uint64_t ticks);
+
+   private:
+    /// slot index of the timers being expired by `tick`
+    static constexpr uint32_t DUE = LEVELS * SLOTS;
+
+    /// put `timer` into the slot for its expiry, relative to the current tick; `timer` must not be scheduled
+    void insert(Timer& timer);
+    /// remove `timer` from `slot`, moving the last timer of the slot into its position
+    static void remove(std::vector<Timer*>& slot, Timer& timer) noexcept;
+    /// redistribute the timers of the current slot of `level`
+    void cascade(size_t level);
+    /// the timers of slot `slot`, which may be `DUE`
+    std::vector<Timer*>& timers(uint32_t slot) noexcept {
+        return slot == DUE ? m_due : m_slots[slot];
+    }
+
+    /// the slots of all levels, level by level, each an array of timers
+    std::array<std::vector<Timer*>, LEVELS * SLOTS> m_slots{};
+    /// the timers being expired, swapped with the due slot to keep both capacities
+    std::vector<Timer*> m_due;
+    /// the timers being cascaded, swapped with the cascaded slot to keep both capacities
+    std::vector<Timer*> m_cascade;
+    /// current tick
+    uint64_t m_now{};
+    /// number of scheduled timers
+    size_t m_size{};
+};
+
+#endif  // TIMINGWHEEL_HPP
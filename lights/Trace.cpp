@@ -0,0 +1,99 @@
+#include "Trace.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <ios>
+#include <span>
+#include <stdexcept>
+#include <string>
+
+namespace {
+/// write the object representation of `value`
+template <typename T>
+void writeRaw(std::ofstream& out, T const& value) {
+    out.write(reinterpret_cast<char const*>(&value), sizeof(T));  // NOLINT(*-pro-type-reinterpret-cast)
+}
+}  // namespace
+
+TraceWriter::TraceWriter(std::string const& path, uint32_t instances)
+    : m_out{path, std::ios::binary | std::ios::trunc},
+      m_header{TraceHeader::MAGIC, TraceHeader::VERSION, instances, 0, 0, 0} {
+    if (!m_out) {
+        throw std::runtime_error{"Cannot create trace " + path};
+    }
+    m_pending.reserve(MAX_BLOCK);
+    // placeholder, overwritten by close
+    writeRaw(m_out, m_header);
+}
+
+TraceWriter::~TraceWriter() {
+    if (m_out.is_open()) {
+        try {
+            close();
+        } catch (std::exception const&) {  // NOLINT(bugprone-empty-catch): destructors must not throw
+        }
+    }
+}
+
+void TraceWriter::write(uint32_t instance, uint32_t input) {
+    write(instance, std::span<uint32_t const>{&input, 1});
+}
+
+void TraceWriter::write(uint32_t instance, std::span<uint32_t const> inputs) {
+    if (instance >= m_header.instances) {
+        throw std::out_of_range{"TraceWriter: unknown instance"};
+    }
+    if (instance != m_instance) {
+        flushBlock();
+        m_instance = instance;
+    }
+    while (!inputs.empty()) {
+        auto const count = std::min(inputs.size(), MAX_BLOCK - m_pending.size());
+        m_pending.insert(m_pending.end(), inputs.begin(), inputs.begin() + static_cast<std::ptrdiff_t>(count));
+        inputs = inputs.subspan(count);
+        if (m_pending.size() == MAX_BLOCK) {
+            flushBlock();
+        }
+    }
+}
+
+void TraceWriter::close() {
+    flushBlock();
+    m_out.seekp(0);
+    writeRaw(m_out, m_header);
+    m_out.close();
+    if (m_out.fail()) {
+        throw std::runtime_error{"Writing trace failed"};
+    }
+}
+
+void TraceWriter::flushBlock() {
+    if (m_pending.empty()) {
+        return;
+    }
+    writeRaw(m_out, TraceBlock{m_instance, static_cast<uint32_t>(m_pending.size())});
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast): raw output
+    m_out.write(reinterpret_cast<char const*>(m_pending.data()),
+                static_cast<std::streamsize>(m_pending.size() * sizeof(uint32_t)));
+    m_header.inputs += m_pending.size();
+    ++m_header.blocks;
+    m_pending.clear();
+}
+
+TraceReader::TraceReader(std::string const& path) : m_file{path} {
+    auto const data = m_file.data();
+    if (data.size() < sizeof(TraceHeader)) {
+        throw std::runtime_error{"Trace " + path + " has no header"};
+    }
+    std::memcpy(&m_header, data.data(), sizeof(TraceHeader));
+    if (m_header.magic != TraceHeader::MAGIC) {
+        throw std::runtime_error{"Not a trace: " + path};
+    }
+    if (m_header.version != TraceHeader::VERSION) {
+        throw std::runtime_error{"Unsupported trace version " + std::to_string(m_header.version)};
+    }
+    m_file.adviseSequential();
+}
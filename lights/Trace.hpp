@@ -0,0 +1,162 @@
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "MappedFile.hpp"
+
+/**
+ * Binary trace of inputs to many lights instances.
+ *
+ * A trace file starts with a `TraceHeader`, followed by blocks. Each block is a `TraceBlock` followed by `count` inputs
+ * to instance `instance`, all values are `uint32_t` in host byte order. Consecutive inputs to the same instance are
+ * stored in one block, so that a replay can hand them to `processInputs` in one call, straight from the file mapping.
+ */
+struct TraceHeader {
+    /// "LTRC" in little endian byte order
+    static constexpr uint32_t MAGIC = 0x4352544C;
+    /// current format version
+    static constexpr uint32_t VERSION = 1;
+
+    /// must be `MAGIC`
+    uint32_t magic;
+    /// must be `VERSION`
+    uint32_t version;
+    /// number of instances, instance IDs are smaller than this
+    uint32_t instances;
+    /// reserved, zero
+    uint32_t reserved;
+    /// total number of inputs
+    uint64_t inputs;
+    /// total number of blocks
+    uint64_t blocks;
+};
+
+/// Header of a block of inputs to one instance.
+struct TraceBlock {
+    /// the instance receiving the inputs
+    uint32_t instance;
+    /// the number of inputs following the header
+    uint32_t count;
+};
+
+/**
+ * Writer creating a trace file.
+ *
+ * Inputs are collected until an input to another instance is written or `MAX_BLOCK` inputs are collected, and then
+ * written as one block. The header is written by `close`.
+ */
+class TraceWriter {
+   public:
+    /// Maximum number of inputs per block.
+    static constexpr size_t MAX_BLOCK = 4096;
+
+    /// Create (or truncate) the file at `path` for a trace of `instances` instances. Throws `std::runtime_error`.
+    TraceWriter(std::string const& path, uint32_t instances);
+
+    /// Close the trace unless this was already done, errors are ignored.
+    ~TraceWriter();
+
+    TraceWriter(TraceWriter const&) = delete;
+    TraceWriter(TraceWriter&&) = delete;
+    TraceWriter& operator=(TraceWriter const&) = delete;
+    TraceWriter& operator=(TraceWriter&&) = delete;
+
+    /// Append an input to `instance`. Throws `std::out_of_range` for unknown instances.
+    void write(uint32_t instance, uint32_t input);
+
+    /// Append inputs to `instance`. Throws `std::out_of_range` for unknown instances.
+    void write(uint32_t instance, std::span<uint32_t const> inputs);
+
+    /// Write pending inputs and the header and close the file. Throws `std::runtime_error` if writing failed.
+    void close();
+
+   private:
+    /// write the pending inputs as a block
+    void flushBlock();
+
+    /// the file
+    std::ofstream m_out;
+    /// the header, counters are updated as blocks are written
+    TraceHeader m_header;
+    /// instance of pending inputs
+    uint32_t m_instance{};
+    /// inputs not written yet, all to `m_instance`
+    std::vector<uint32_t> m_pending;
+};
+
+/**
+ * Reader accessing a trace file through a memory mapping.
+ *
+ * The header is validated on construction. Blocks are validated as they are visited by `forEach`, which passes the
+ * inputs as spans pointing into the mapping. Nothing is parsed or copied, so multi-gigabyte traces are streamed at
+ * the speed of the page cache; pages already visited are dropped from the resident set periodically.
+ */
+class TraceReader {
+   public:
+    /// Map the trace at `path`. Throws `std::system_error` or `std::runtime_error` if it cannot be read.
+    explicit TraceReader(std::string const& path);
+
+    /// The validated header.
+    [[nodiscard]] TraceHeader const& header() const noexcept {
+        return m_header;
+    }
+
+    /// Size of the trace file in bytes.
+    [[nodiscard]] size_t bytes() const noexcept {
+        return m_file.data().size();
+    }
+
+    /**
+     * Call `visit(instance, inputs)` for every block in order, `inputs` is a `std::span<uint32_t const>`.
+     *
+     * Throws `std::runtime_error` if the trace is truncated or refers to unknown instances.
+     */
+    template <typename Visitor>
+    void forEach(Visitor&& visit) const {
+        auto const data = m_file.data();
+        auto offset = sizeof(TraceHeader);
+        auto released = size_t{0};
+        for (uint64_t block = 0; block < m_header.blocks; ++block) {
+            if (data.size() - offset < sizeof(TraceBlock)) {
+                throw std::runtime_error{"Trace truncated"};
+            }
+            // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast): blocks are 4 byte aligned in the mapping
+            auto const* header = reinterpret_cast<TraceBlock const*>(data.data() + offset);
+            offset += sizeof(TraceBlock);
+            if (header->instance >= m_header.instances) {
+                throw std::runtime_error{"Trace refers to unknown instance"};
+            }
+            if ((data.size() - offset) / sizeof(uint32_t) < header->count) {
+                throw std::runtime_error{"Trace truncated"};
+            }
+            // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast): see above
+            auto const* inputs = reinterpret_cast<uint32_t const*>(data.data() + offset);
+            offset += header->count * sizeof(uint32_t);
+
+            visit(header->instance, std::span<uint32_t const>{inputs, header->count});
+
+            if (offset - released >= RELEASE_INTERVAL) {
+                m_file.release(offset);
+                released = offset;
+            }
+        }
+    }
+
+   private:
+    /// number of bytes visited before pages are dropped from the resident set
+    static constexpr size_t RELEASE_INTERVAL = size_t{64} * 1024 * 1024;
+
+    /// the mapping
+    MappedFile m_file;
+    /// copy of the header
+    TraceHeader m_header{};
+};
+
+#endif  // TRACE_HPP
@@ -0,0 +1,62 @@
+#ifndef TRANSITIONSINK_HPP
+#define TRANSITIONSINK_HPP
+
+#include <cstdint>
+#include <ostream>
+
+/// Compact binary record of something observed by a lights instance.
+struct TransitionEvent {
+    /// What happened.
+    enum class Kind : uint32_t {
+        /// lights switched from `first` to `second`
+        Transition,
+        /// input `first` rejected, there are only `second` states
+        OutOfBounds,
+        /// the instance's thread was interrupted
+        Interrupted,
+    };
+
+    /// tag of the instance, see `Lights::setSink`
+    uint32_t tag;
+    /// what happened
+    Kind kind;
+    /// first value, meaning depends on `kind`
+    uint32_t first;
+    /// second value, meaning depends on `kind`
+    uint32_t second;
+};
+
+/// Format an event as human readable debug message (including the trailing newline).
+inline std::ostream& operator<<(std::ostream& out, TransitionEvent const& event) {
+    switch (event.kind) {
+        case TransitionEvent::Kind::Transition:
+            return out << "Switching lights from " << event.first << " to " << event.second << "\n";
+        case TransitionEvent::Kind::OutOfBounds:
+            return out << "Out of bounds: " << event.first << " >= " << event.second << "\n";
+        case TransitionEvent::Kind::Interrupted:
+            return out << "Thread interrupted.\n";
+    }
+    return out;
+}
+
+/**
+ * Observer interface receiving the events of lights instances.
+ *
+ * `record` is called on the hot path of the lights, from whatever thread processes the inputs. Implementations must be
+ * thread-safe and should return quickly.
+ */
+class TransitionSink {
+   public:
+    TransitionSink() = default;
+    virtual ~TransitionSink() = default;
+
+    TransitionSink(TransitionSink const&) = delete;
+    TransitionSink(TransitionSink&&) = delete;
+    TransitionSink& operator=(TransitionSink const&) = delete;
+    TransitionSink& operator=(TransitionSink&&) = delete;
+
+    /// Record an event.
+    virtual void record(TransitionEvent const& event) noexcept = 0;
+};
+
+#endif  // TRANSITIONSINK_HPP
@@ -0,0 +1,117 @@
+#include "WorkStealingPool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+
+namespace {
+// NOLINTBEGIN(cppcoreguidelines-avoid-non-const-global-variables): thread identity of the workers
+/// the pool the current thread is a worker of, `nullptr` for threads outside any pool
+thread_local WorkStealingPool const* t_pool{nullptr};
+/// the index of the current thread in its pool
+thread_local size_t t_index{0};
+// NOLINTEND(cppcoreguidelines-avoid-non-const-global-variables)
+}  // namespace
+
+WorkStealingPool::WorkStealingPool(size_t threads) {
+    threads = std::max<size_t>(threads, 1);
+    m_workers.reserve(threads);
+    for (size_t i = 0; i < threads; ++i) {
+        m_workers.push_back(std::make_unique<Worker>());
+    }
+    // start threads only once all workers exist, they steal from each other
+    for (size_t i = 0; i < threads; ++i) {
+        m_workers[i]->thread = std::thread{[this, i]() { this->work(i); }};
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        std::lock_guard<std::mutex> const lock{m_mutex};
+        m_stop = true;
+    }
+    m_workAvailable.notify_all();
+    for (auto& worker : m_workers) {
+        worker->thread.join();
+    }
+}
+
+void WorkStealingPool::schedule(std::coroutine_handle<> handle) {
+    m_pending.fetch_add(1, std::memory_order_relaxed);
+
+    auto const index =
+        t_pool == this ? t_index : m_nextWorker.fetch_add(1, std::memory_order_relaxed) % m_workers.size();
+    push(index, handle);
+
+    // sequentially consistent with the increment of m_sleeping in `work`: either the parking worker sees the queued
+    // co-routine or we see the parking worker
+    if (m_sleeping.load() > 0) {
+        std::lock_guard<std::mutex> const lock{m_mutex};
+        m_workAvailable.notify_one();
+    }
+}
+
+void WorkStealingPool::wait() {
+    std::unique_lock<std::mutex> lock{m_mutex};
+    m_idle.wait(lock, [this]() { return m_pending.load() == 0; });
+}
+
+void WorkStealingPool::work(size_t index) {
+    t_pool = this;
+    t_index = index;
+
+    std::coroutine_handle<> handle{};
+    while (!m_stop.load(std::memory_order_relaxed)) {
+        if (pop(index, handle) || steal(index, handle)) {
+            handle.resume();
+            if (m_pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                std::lock_guard<std::mutex> const lock{m_mutex};
+                m_idle.notify_all();
+            }
+            continue;
+        }
+
+        // nothing to do, park until work is queued
+        std::unique_lock<std::mutex> lock{m_mutex};
+        m_sleeping.fetch_add(1);
+        m_workAvailable.wait(lock, [this]() { return m_stop.load() || m_queued.load() > 0; });
+        m_sleeping.fetch_sub(1);
+    }
+}
+
+void WorkStealingPool::push(size_t index, std::coroutine_handle<> handle) {
+    // count first, so that the counter never underflows when the co-routine is taken right away
+    m_queued.fetch_add(1);
+    auto& worker = *m_workers[index];
+    std::lock_guard<SpinLock> const lock{worker.lock};
+    worker.deque.push_back(handle);
+}
+
+bool WorkStealingPool::pop(size_t index, std::coroutine_handle<>& handle) {
+    auto& worker = *m_workers[index];
+    std::lock_guard<SpinLock> const lock{worker.lock};
+    if (worker.deque.empty()) {
+        return false;
+    }
+    handle = worker.deque.back();
+    worker.deque.pop_back();
+    m_queued.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+}
+
+bool WorkStealingPool::steal(size_t index, std::coroutine_handle<>& handle) {
+    for (size_t offset = 1; offset < m_workers.size(); ++offset) {
+        auto& victim = *m_workers[(index + offset) % m_workers.size()];
+        std::lock_guard<SpinLock> const lock{victim.lock};
+        if (!victim.deque.empty()) {
+            handle = victim.deque.front();
+            victim.deque.pop_front();
+            m_queued.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,91 @@
+#ifndef WORKSTEALINGPOOL_HPP
+#define WORKSTEALINGPOOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Scheduler.hpp"
+#include "SpinLock.hpp"
+
+/**
+ * Thread pool resuming co-routines on all cores (M:N scheduling of co-routines onto kernel threads).
+ *
+ * Every worker thread owns a deque of ready co-routines. Co-routines scheduled from a worker thread are pushed to the
+ * back of that worker's deque, co-routines scheduled from any other thread are distributed round-robin. A worker pops
+ * from the back of its own deque. When it runs out of work, it steals from the front of the other workers' deques, and
+ * only when there is nothing left to steal it parks on a condition variable.
+ *
+ * A co-routine is resumed by one worker at a time, but consecutive resumes may happen on different workers.
+ */
+class WorkStealingPool final : public Scheduler {
+   public:
+    /// Start a pool with `threads` worker threads (at least one).
+    explicit WorkStealingPool(size_t threads = std::thread::hardware_concurrency());
+
+    /// Stop and join all worker threads. Co-routines still queued are not resumed.
+    ~WorkStealingPool() override;
+
+    WorkStealingPool(WorkStealingPool const&) = delete;
+    WorkStealingPool(WorkStealingPool&&) = delete;
+    WorkStealingPool& operator=(WorkStealingPool const&) = delete;
+    WorkStealingPool& operator=(WorkStealingPool&&) = delete;
+
+    /// Number of worker threads.
+    [[nodiscard]] size_t threads() const noexcept {
+        return m_workers.size();
+    }
+
+    /// Queue a suspended co-routine to be resumed by one of the workers. May be called from any thread.
+    void schedule(std::coroutine_handle<> handle) override;
+
+    /// Block until all scheduled co-routines have been resumed and no more co-routines are ready.
+    void wait();
+
+   private:
+    /// A worker thread and its deque, aligned to avoid false sharing between workers.
+    struct alignas(64) Worker {
+        /// protects the deque
+        SpinLock lock;
+        /// ready co-routines, the owner works at the back, thieves at the front
+        std::deque<std::coroutine_handle<>> deque;
+        /// the worker thread
+        std::thread thread;
+    };
+
+    /// main loop of the worker with given index
+    void work(size_t index);
+    /// push a co-routine to the back of the given worker's deque
+    void push(size_t index, std::coroutine_handle<> handle);
+    /// pop a co-routine from the back of the own deque
+    bool pop(size_t index, std::coroutine_handle<>& handle);
+    /// steal a co-routine from the front of another worker's deque
+    bool steal(size_t index, std::coroutine_handle<>& handle);
+
+    /// the workers, individually allocated so that they are not moved
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    /// number of co-routines in all deques
+    std::atomic<size_t> m_queued{0};
+    /// number of co-routines scheduled but not yet completely resumed, `wait` returns when it drops to zero
+    std::atomic<size_t> m_pending{0};
+    /// number of parked workers
+    std::atomic<size_t> m_sleeping{0};
+    /// round-robin counter to distribute co-routines scheduled from outside the pool
+    std::atomic<size_t> m_nextWorker{0};
+    /// set to stop the workers
+    std::atomic<bool> m_stop{false};
+    /// protects parking and `wait`
+    std::mutex m_mutex;
+    /// signaled when work is queued or the pool is stopped
+    std::condition_variable m_workAvailable;
+    /// signaled when the pool becomes idle
+    std::condition_variable m_idle;
+};
+
+#endif  // WORKSTEALINGPOOL_HPP
@@ -1,10 +1,97 @@
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
 #include <cstdint>
+#include <cstdlib>
+#include <ctime>
+#include <exception>
+#include <fstream>
 #include <iostream>
+#include <memory>
+#include <new>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <vector>
 
 #include "CoRoutineLights.hpp"
+#include "FiberLights.hpp"
+#include "FramePool.hpp"
 #include "Lights.hpp"
+#include "LightsExecutor.hpp"
+#include "LightsChanges.hpp"
+#include "LightsGraph.hpp"
+#include "LightsServer.hpp"
+#include "LightsStats.hpp"
+#include "LightsVariant.hpp"
+#include "RingBufferSink.hpp"
+#include "ShardedRuntime.hpp"
+#include "ShmRing.hpp"
+#include "Snapshot.hpp"
 #include "StateMachineLights.hpp"
+#include "StateTable.hpp"
+#include "StaticLights.hpp"
+#include "TableSlot.hpp"
+#include "Task.hpp"
 #include "ThreadLights.hpp"
+#include "TimedLights.hpp"
+#include "Trace.hpp"
+#include "WorkStealingPool.hpp"
+
+/// calls to the global `operator new` so far, counted by the replacements below
+std::atomic<uint64_t> globalAllocations{0};
+
+// Replacements of the global allocation functions counting allocations, so that `frames` reports every allocation
+// from the global heap, not only those the frame pool knows about. The array, nothrow and sized forms of the standard
+// library forward to these. They are not inlined, so that GCC does not pair a `new` expression with the `free` inside
+// and report -Wmismatched-new-delete.
+
+[[gnu::noinline]] void* operator new(size_t size) {
+    globalAllocations.fetch_add(1, std::memory_order_relaxed);
+    if (auto* const memory = std::malloc(size == 0 ? 1 : size)) {  // NOLINT(*-no-malloc)
+        return memory;
+    }
+    throw std::bad_alloc{};
+}
+
+[[gnu::noinline]] void* operator new(size_t size, std::align_val_t alignment) {
+    globalAllocations.fetch_add(1, std::memory_order_relaxed);
+    auto const align = std::max(static_cast<size_t>(alignment), sizeof(void*));
+    // aligned_alloc requires a multiple of the alignment
+    auto const rounded = (std::max<size_t>(size, 1) + align - 1) / align * align;
+    if (auto* const memory = std::aligned_alloc(align, rounded)) {  // NOLINT(*-no-malloc)
+        return memory;
+    }
+    throw std::bad_alloc{};
+}
+
+[[gnu::noinline]] void operator delete(void* memory) noexcept {
+    std::free(memory);  // NOLINT(*-no-malloc, *-owning-memory)
+}
+
+[[gnu::noinline]] void operator delete(void* memory, size_t /*size*/) noexcept {
+    std::free(memory);  // NOLINT(*-no-malloc, *-owning-memory)
+}
+
+[[gnu::noinline]] void operator delete(void* memory, std::align_val_t /*alignment*/) noexcept {
+    std::free(memory);  // NOLINT(*-no-malloc, *-owning-memory)
+}
+
+[[gnu::noinline]] void operator delete(void* memory, size_t /*size*/, std::align_val_t /*alignment*/) noexcept {
+    std::free(memory);  // NOLINT(*-no-malloc, *-owning-memory)
+}
 
 constexpr uint32_t OFF = 0;
 constexpr uint32_t GREEN = 1;
@@ -19,7 +106,8 @@ constexpr uint32_t S_RED_YELLOW = 4;
 constexpr uint32_t S_LEN = 5;
 constexpr uint32_t S_OUT_OF_BOUNDS = 99;
 
-void initLights(Lights& lights) {
+template <LightsType L>
+void initLights(L& lights) {
     lights.processInput(S_LEN);
 
     lights.processInput(OFF);
@@ -29,9 +117,8 @@ void initLights(Lights& lights) {
     lights.processInput(RED | YELLOW);
 }
 
-void initAndUseLights(Lights& lights) {
-    initLights(lights);
-
+template <LightsType L>
+void useLights(L& lights) {
     lights.processInput(S_GREEN);
     lights.processInput(S_YELLOW);
     lights.processInput(S_OUT_OF_BOUNDS);
@@ -39,12 +126,28 @@ void initAndUseLights(Lights& lights) {
     lights.processInput(S_RED_YELLOW);
 }
 
-int main() {
+template <LightsType L>
+void initAndUseLights(L& lights) {
+    initLights(lights);
+    useLights(lights);
+}
+
+/// Lights with the same states as set by `initLights`, fixed at compile time.
+using StaticTrafficLights = StaticLights<OFF, RED, GREEN, YELLOW, RED | YELLOW>;
+static_assert(StaticTrafficLights::STATES.size() == S_LEN);
+
+/**
+ * Run the fixed input script on each implementation, printing all transitions.
+ *
+ * Transitions are printed asynchronously by the console sink, so it is flushed before printing anything else.
+ */
+void runDemo() {
     std::cout << "---------------------- [START] StateMachineLights --------------------\n";
     {
         StateMachineLights lights{};
         initAndUseLights(lights);
     }
+    RingBufferSink::console().flush();
     std::cout << "---------------------- [END] StateMachineLights ----------------------\n\n";
 
     std::cout << "---------------------- [START] CoRoutineLights -----------------------\n";
@@ -52,6 +155,7 @@ int main() {
         CoRoutineLights lights{};
         initAndUseLights(lights);
     }
+    RingBufferSink::console().flush();
     std::cout << "---------------------- [END] CoRoutineLights -------------------------\n\n";
 
     std::cout << "---------------------- [START] ThreadLights --------------------------\n";
@@ -59,7 +163,990 @@ int main() {
         ThreadLights lights{};
         initAndUseLights(lights);
     }
+    RingBufferSink::console().flush();
     std::cout << "---------------------- [END] ThreadLights ----------------------------\n\n";
 
+    std::cout << "---------------------- [START] FiberLights ---------------------------\n";
+    {
+        FiberLights lights{};
+        initAndUseLights(lights);
+    }
+    RingBufferSink::console().flush();
+    std::cout << "---------------------- [END] FiberLights -----------------------------\n\n";
+
+    std::cout << "---------------------- [START] StaticLights --------------------------\n";
+    {
+        StaticTrafficLights lights{};
+        useLights(lights);
+    }
+    RingBufferSink::console().flush();
+    std::cout << "---------------------- [END] StaticLights ----------------------------\n\n";
+
     std::cout << "======================================================================\n";
 }
+
+/// Print the process-wide instrumentation counters and latency histogram quantiles, and the interned state tables.
+void printStats() {
+    std::cout << "stats: " << aggregateStats() << "\n";
+    auto const tables = StateTableRegistry::instance().stats();
+    std::cout << "tables: " << tables.tables << " distinct, " << tables.states << " states, " << tables.interned
+              << " interned, " << tables.hits << " shared\n";
+}
+
+/**
+ * Drive `instances` co-routine lights through a `LightsExecutor`, `inputs` RUN inputs per instance, and report the
+ * throughput.
+ *
+ * Each tick posts one input to every instance and then runs the loop until all instances are idle.
+ */
+void runExecutor(size_t instances, size_t inputs) {
+    Lights::setDefaultSink(nullptr);
+
+    LightsExecutor executor{};
+    for (size_t i = 0; i < instances; ++i) {
+        initLights(executor[executor.spawn()]);
+    }
+    executor.run();
+
+    auto const start = std::chrono::steady_clock::now();
+    for (size_t k = 0; k < inputs; ++k) {
+        auto const input = static_cast<uint32_t>(k % S_LEN);
+        for (LightsExecutor::Id id = 0; id < instances; ++id) {
+            executor.post(id, input);
+        }
+        executor.run();
+    }
+    std::chrono::duration<double> const elapsed = std::chrono::steady_clock::now() - start;
+
+    auto const total = static_cast<double>(instances * inputs);
+    std::cout << "executor: " << instances << " instances, " << inputs << " inputs each, " << elapsed.count()
+              << " s, " << total / elapsed.count() << " inputs/s\n";
+    printStats();
+}
+
+/**
+ * Drive `instances` co-routine lights on a `WorkStealingPool` with 1 to `maxThreads` threads, `inputs` RUN inputs per
+ * instance, and report throughput and speed-up for each number of threads.
+ *
+ * The inputs are posted as one block per instance, so that the posting thread does not limit the throughput.
+ */
+void runPool(size_t instances, size_t inputs, size_t maxThreads) {
+    Lights::setDefaultSink(nullptr);
+
+    std::vector<uint32_t> block(inputs);
+    for (size_t k = 0; k < inputs; ++k) {
+        block[k] = static_cast<uint32_t>(k % S_LEN);
+    }
+
+    double baseline{};
+    for (size_t threads = 1; threads <= maxThreads; ++threads) {
+        WorkStealingPool pool{threads};
+        std::vector<std::unique_ptr<CoRoutineLights>> fleet{};
+        fleet.reserve(instances);
+        for (size_t i = 0; i < instances; ++i) {
+            fleet.push_back(std::make_unique<CoRoutineLights>(&pool));
+            initLights(*fleet.back());
+        }
+        pool.wait();
+
+        auto const start = std::chrono::steady_clock::now();
+        for (auto& lights : fleet) {
+            lights->processInputs(block);
+        }
+        pool.wait();
+        std::chrono::duration<double> const elapsed = std::chrono::steady_clock::now() - start;
+
+        auto const rate = static_cast<double>(instances * inputs) / elapsed.count();
+        if (threads == 1) {
+            baseline = rate;
+        }
+        std::cout << "pool: " << threads << " threads, " << instances << " instances, " << inputs << " inputs each, "
+                  << elapsed.count() << " s, " << rate << " inputs/s, speed-up " << rate / baseline << "\n";
+    }
+    printStats();
+}
+
+/**
+ * Create, initialize and destroy `instances` co-routine lights in each of `rounds` rounds and report the cost per
+ * instance together with the number of allocations from the frame pool and from the global heap, as counted by the
+ * replaced global `operator new`.
+ *
+ * After the first round has warmed up the pool, no more global heap allocations are expected. The state table of the
+ * instances is interned up front and kept alive for all rounds; otherwise it would be freed with the last instance of
+ * a round and created again with a few global heap allocations by the next one.
+ */
+void runFrames(size_t instances, size_t rounds) {
+    Lights::setDefaultSink(nullptr);
+
+    auto const table = StateTableRegistry::instance().intern(std::array<uint32_t, S_LEN>{OFF, RED, GREEN, YELLOW,
+                                                                                         RED | YELLOW});
+    auto const& pool = FramePool::instance();
+    std::vector<std::optional<CoRoutineLights>> fleet(instances);
+    for (size_t round = 0; round < rounds; ++round) {
+        auto const before = pool.stats();
+        auto const allocations = globalAllocations.load(std::memory_order_relaxed);
+        auto const start = std::chrono::steady_clock::now();
+        for (auto& lights : fleet) {
+            initLights(lights.emplace());
+        }
+        for (auto& lights : fleet) {
+            lights.reset();
+        }
+        std::chrono::duration<double, std::nano> const elapsed = std::chrono::steady_clock::now() - start;
+        auto const heap = globalAllocations.load(std::memory_order_relaxed) - allocations;
+        auto const after = pool.stats();
+
+        std::cout << "frames: round " << round << ", " << instances << " instances, "
+                  << elapsed.count() / static_cast<double>(instances) << " ns per instance, "
+                  << after.allocations - before.allocations << " pool allocations, "
+                  << after.upstreamAllocations - before.upstreamAllocations << " of them from upstream, " << heap
+                  << " global heap allocations\n";
+    }
+}
+
+/**
+ * Run `instances` timed lights on one executor for `seconds` of simulated time and report how much faster than real
+ * time the city is simulated.
+ *
+ * Every instance cycles through red, red-yellow, green and yellow. Phases last 20 to 59 s and the first phase starts 0
+ * to 89 s after INIT, so that the timers of the instances are spread over many ticks. Every simulated minute, one
+ * instance in 100 is forced back to red, e.g. for an emergency vehicle.
+ */
+void runTimers(size_t instances, size_t seconds) {
+    Lights::setDefaultSink(nullptr);
+
+    constexpr auto TICK = std::chrono::milliseconds{10};
+    constexpr auto MINUTE = std::chrono::seconds{60};
+    constexpr size_t PHASES = 40;
+    constexpr size_t OFFSETS = 90;
+    constexpr size_t FORCED = 100;
+    std::array<uint32_t, 5> const plan{4, RED, RED | YELLOW, GREEN, YELLOW};
+
+    LightsExecutor executor{TICK};
+    // declared after the executor, so that the instances are destroyed first
+    std::vector<std::unique_ptr<TimedLights>> fleet{};
+    fleet.reserve(instances);
+    for (size_t i = 0; i < instances; ++i) {
+        auto const phase = std::chrono::seconds{20 + i % PHASES};
+        auto const offset = std::chrono::seconds{i % OFFSETS};
+        fleet.push_back(std::make_unique<TimedLights>(executor, phase, offset));
+        fleet.back()->processInputs(plan);
+    }
+    executor.run();
+
+    size_t expired = 0;
+    auto const end = std::chrono::seconds{seconds};
+    auto const start = std::chrono::steady_clock::now();
+    for (size_t minute = 0; executor.now() < end; ++minute) {
+        expired += executor.advance(std::min<LightsExecutor::Duration>(MINUTE, end - executor.now()));
+        for (size_t i = minute % FORCED; i < instances; i += FORCED) {
+            fleet[i]->processInput(0);
+        }
+    }
+    executor.run();
+    std::chrono::duration<double> const elapsed = std::chrono::steady_clock::now() - start;
+
+    std::cout << "timers: " << instances << " instances, " << seconds << " s simulated in " << elapsed.count()
+              << " s, speed-up " << static_cast<double>(seconds) / elapsed.count() << ", " << expired
+              << " timers expired, " << static_cast<double>(expired) / elapsed.count() << " timers/s, "
+              << executor.timers().size() << " pending\n";
+    fleet.clear();
+    printStats();
+}
+
+/// Translate lights into the state following them in the traffic light cycle.
+uint32_t nextState(uint32_t lights) noexcept {
+    switch (lights) {
+        case RED:
+            return S_RED_YELLOW;
+        case RED | YELLOW:
+            return S_GREEN;
+        case GREEN:
+            return S_YELLOW;
+        default:
+            return S_RED;
+    }
+}
+
+/**
+ * Connect `nodes` state machine lights as a binary tree in a `LightsGraph`, feed `inputs` inputs to the root and report
+ * how fast the transitions propagate to all nodes.
+ *
+ * Each node switches to the state following the lights of its parent, so every input to the root is delivered to all
+ * other nodes.
+ */
+void runGraph(size_t nodes, size_t inputs) {
+    Lights::setDefaultSink(nullptr);
+
+    std::vector<StateMachineLights> fleet(nodes);
+    LightsGraph::Builder builder{};
+    for (auto& lights : fleet) {
+        builder.add(lights);
+    }
+    for (LightsGraph::Node node = 1; node < nodes; ++node) {
+        builder.connect((node - 1) / 2, node, nextState);
+    }
+    LightsGraph graph{builder};
+    for (auto& lights : fleet) {
+        initLights(lights);
+    }
+
+    size_t delivered = 0;
+    auto const start = std::chrono::steady_clock::now();
+    for (size_t k = 0; k < inputs; ++k) {
+        graph.post(0, static_cast<uint32_t>(k % S_LEN));
+        delivered += graph.run();
+    }
+    std::chrono::duration<double> const elapsed = std::chrono::steady_clock::now() - start;
+
+    std::cout << "graph: " << graph.nodes() << " nodes, " << graph.edges() << " edges, " << inputs << " inputs, "
+              << delivered << " values delivered, " << graph.dropped() << " dropped, " << elapsed.count() << " s, "
+              << static_cast<double>(delivered) / elapsed.count() << " values/s\n";
+    printStats();
+}
+
+/// Count the transitions received from `changes` until the lights are switched off.
+Task<size_t> countChanges(LightsChanges& changes) {
+    size_t received = 0;
+    for (bool off = false; !off;) {
+        auto const change = co_await changes;
+        ++received;
+        off = change.to == OFF;
+    }
+    co_return received;
+}
+
+/**
+ * Feed `inputs` RUN inputs to lights watched by a `LightsChanges` stream and report the transitions received by a
+ * consumer which never polls: a co-routine resumed inline by `StateMachineLights`, and a thread blocking on `next()`
+ * while the worker of `ThreadLights` switches.
+ */
+void runChanges(size_t inputs) {
+    Lights::setDefaultSink(nullptr);
+
+    auto const feed = [inputs](Lights& lights) {
+        for (size_t k = 0; k < inputs; ++k) {
+            lights.processInput(k % 2 == 0 ? S_RED : S_GREEN);
+        }
+        lights.processInput(S_OFF);
+    };
+    auto const report = [inputs](std::string_view name, size_t received, LightsChanges const& changes, auto elapsed) {
+        std::chrono::duration<double> const seconds = elapsed;
+        std::cout << "changes: " << name << ", " << inputs + 1 << " inputs, " << received << " transitions received, "
+                  << changes.merged() << " merged, " << seconds.count() * 1e9 / static_cast<double>(inputs + 1)
+                  << " ns per input\n";
+    };
+
+    {
+        StateMachineLights lights{};
+        initLights(lights);
+        LightsChanges changes{lights};
+        auto counter = countChanges(changes);
+        counter.start();
+        auto const start = std::chrono::steady_clock::now();
+        feed(lights);
+        auto const elapsed = std::chrono::steady_clock::now() - start;
+        report("StateMachineLights, co-routine", counter.result(), changes, elapsed);
+    }
+
+    {
+        ThreadLights lights{};
+        initLights(lights);
+        LightsChanges changes{lights};
+        size_t received = 0;
+        std::thread consumer{[&changes, &received]() {
+            while (changes.next().to != OFF) {
+                ++received;
+            }
+            ++received;
+        }};
+        auto const start = std::chrono::steady_clock::now();
+        feed(lights);
+        consumer.join();
+        auto const elapsed = std::chrono::steady_clock::now() - start;
+        report("ThreadLights, thread", received, changes, elapsed);
+    }
+    printStats();
+}
+
+/// CPU time of the calling thread in seconds, to measure a thread that shares its core with others.
+double threadCpuSeconds() {
+    timespec time{};
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+    return static_cast<double>(time.tv_sec) + static_cast<double>(time.tv_nsec) * 1e-9;
+}
+
+/**
+ * Step `instances` state machine lights through `rounds` rounds of inputs on the calling thread, first without and then
+ * with `readers` threads polling the published lights of all instances, and report the cost per input of the writer
+ * and the snapshot rate of the readers.
+ *
+ * The writer cost is measured in CPU time of the writing thread, so that readers sharing its core do not count.
+ * Round `r` selects state `r % S_LEN` of every instance, so the readers check that each snapshot entry is consistent:
+ * its lights must be the state selected in the round given by its sequence number.
+ */
+void runMonitor(size_t instances, size_t rounds, size_t readers) {
+    Lights::setDefaultSink(nullptr);
+    constexpr std::array<uint32_t, S_LEN> STATES{OFF, RED, GREEN, YELLOW, RED | YELLOW};
+
+    for (auto const threads : {size_t{0}, readers}) {
+        std::vector<std::unique_ptr<StateMachineLights>> fleet{};
+        std::vector<Lights const*> view{};
+        fleet.reserve(instances);
+        view.reserve(instances);
+        for (size_t i = 0; i < instances; ++i) {
+            fleet.push_back(std::make_unique<StateMachineLights>());
+            initLights(*fleet.back());
+            view.push_back(fleet.back().get());
+        }
+
+        std::atomic<bool> stop{false};
+        std::atomic<size_t> snapshots{0};
+        std::atomic<size_t> torn{0};
+        std::vector<std::thread> pollers{};
+        for (size_t t = 0; t < threads; ++t) {
+            pollers.emplace_back([&]() {
+                std::vector<PublishedLights> snapshot(instances);
+                while (!stop.load(std::memory_order_relaxed)) {
+                    Lights::published(view, snapshot);
+                    for (auto const& entry : snapshot) {
+                        auto const expected = entry.sequence == 0 ? OFF : STATES[(entry.sequence - 1) % S_LEN];
+                        if (entry.lights != expected) {
+                            torn.fetch_add(1, std::memory_order_relaxed);
+                        }
+                    }
+                    snapshots.fetch_add(1, std::memory_order_relaxed);
+                }
+            });
+        }
+
+        auto const start = std::chrono::steady_clock::now();
+        auto const cpuStart = threadCpuSeconds();
+        for (size_t r = 0; r < rounds; ++r) {
+            for (auto& lights : fleet) {
+                lights->processInput(static_cast<uint32_t>(r % S_LEN));
+            }
+        }
+        auto const cpuElapsed = threadCpuSeconds() - cpuStart;
+        std::chrono::duration<double> const elapsed = std::chrono::steady_clock::now() - start;
+        stop.store(true, std::memory_order_relaxed);
+        for (auto& poller : pollers) {
+            poller.join();
+        }
+
+        auto const published = fleet.front()->published();
+        std::cout << "monitor: " << threads << " readers, " << instances << " instances, " << rounds << " rounds, "
+                  << cpuElapsed * 1e9 / static_cast<double>(instances * rounds) << " ns per input (writer CPU), "
+                  << static_cast<double>(snapshots.load()) / elapsed.count() << " snapshots/s, " << torn.load()
+                  << " inconsistent entries, sequence " << published.sequence << "\n";
+    }
+    printStats();
+}
+
+/**
+ * Step `instances` state machine lights sharing one timing plan through `rounds` rounds of inputs on the calling
+ * thread, first without and then with another thread replacing the plan `plans` times, and report the cost per input.
+ *
+ * The plan alternates between the day plan of `initLights` and a night plan that only flashes yellow. The writer cost
+ * is measured in CPU time of the writing thread, so that the replacing thread sharing its core does not count.
+ */
+void runPlans(size_t instances, size_t rounds, size_t plans) {
+    Lights::setDefaultSink(nullptr);
+    auto& registry = StateTableRegistry::instance();
+    auto const day = registry.intern(std::array<uint32_t, S_LEN>{OFF, RED, GREEN, YELLOW, RED | YELLOW});
+    auto const night = registry.intern(std::array<uint32_t, S_LEN>{OFF, YELLOW, OFF, YELLOW, OFF});
+
+    for (auto const replacements : {size_t{0}, plans}) {
+        auto const city = std::make_shared<TableSlot>(day);
+        std::vector<std::unique_ptr<StateMachineLights>> fleet{};
+        fleet.reserve(instances);
+        for (size_t i = 0; i < instances; ++i) {
+            fleet.push_back(std::make_unique<StateMachineLights>());
+            fleet.back()->share(city, OFF);
+        }
+
+        std::atomic<bool> stop{false};
+        size_t replaced = 0;
+        std::thread planner{[&]() {
+            while (replaced < replacements && !stop.load(std::memory_order_relaxed)) {
+                city->replace(replaced % 2 == 0 ? night : day);
+                ++replaced;
+                std::this_thread::yield();
+            }
+        }};
+
+        auto const cpuStart = threadCpuSeconds();
+        for (size_t r = 0; r < rounds; ++r) {
+            for (auto& lights : fleet) {
+                lights->processInput(static_cast<uint32_t>(r % S_LEN));
+            }
+        }
+        auto const cpuElapsed = threadCpuSeconds() - cpuStart;
+        stop.store(true, std::memory_order_relaxed);
+        planner.join();
+
+        // back to the day plan, every instance follows at its next input
+        city->replace(day);
+        size_t following = 0;
+        for (auto& lights : fleet) {
+            lights->processInput(S_RED);
+            following += lights->getLights() == RED ? 1 : 0;
+        }
+        TableSlot::synchronize();
+        auto const retired = TableSlot::stats();
+        std::cout << "plans: " << replaced << " replacements, " << instances << " instances, " << rounds << " rounds, "
+                  << cpuElapsed * 1e9 / static_cast<double>(instances * rounds) << " ns per input (writer CPU), "
+                  << following << " instances following the last plan, " << retired.reclaimed << " of "
+                  << retired.retired << " retired tables released\n";
+    }
+    printStats();
+}
+
+/// Resident memory of the process in KiB.
+size_t residentKiB() {
+    std::ifstream statm{"/proc/self/statm"};
+    size_t pages = 0;
+    size_t resident = 0;
+    statm >> pages >> resident;
+    return resident * static_cast<size_t>(sysconf(_SC_PAGESIZE)) / 1024;
+}
+
+/// Voluntary and involuntary context switches of all threads of the process so far.
+uint64_t contextSwitches() {
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return static_cast<uint64_t>(usage.ru_nvcsw + usage.ru_nivcsw);
+}
+
+/**
+ * Post the INIT inputs of `initLights` and `inputs` RUN inputs in chunks to each of `instances` instances with
+ * `post(id, inputs)`, from `producers` threads each serving every `producers`-th instance.
+ */
+template <typename Post>
+void postInputs(size_t instances, size_t inputs, size_t producers, Post const& post) {
+    static constexpr size_t CHUNK = 16;
+    std::vector<std::thread> threads;
+    for (size_t p = 0; p < std::max<size_t>(producers, 1); ++p) {
+        threads.emplace_back([&post, instances, inputs, producers, p]() {
+            std::array<uint32_t, S_LEN + 1> const init{S_LEN, OFF, RED, GREEN, YELLOW, RED | YELLOW};
+            for (auto id = p; id < instances; id += producers) {
+                post(id, std::span<uint32_t const>{init});
+            }
+            std::array<uint32_t, CHUNK> chunk{};
+            for (size_t k = 0; k < inputs; k += CHUNK) {
+                auto const count = std::min(CHUNK, inputs - k);
+                for (auto id = p; id < instances; id += producers) {
+                    for (size_t i = 0; i < count; ++i) {
+                        chunk.at(i) = static_cast<uint32_t>((id + k + i) % S_LEN);
+                    }
+                    post(id, std::span<uint32_t const>{chunk}.first(count));
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+/**
+ * Feed `instances` blocking-style lights from `producers` threads, `inputs` RUN inputs each, first with a thread per
+ * instance (`ThreadLights`) and then hosted by a `ShardedRuntime` with `shards` pinned worker threads. Report the
+ * throughput, memory and context switches of both.
+ */
+void runShards(size_t instances, size_t inputs, size_t shards, size_t producers) {
+    Lights::setDefaultSink(nullptr);
+    producers = std::max<size_t>(producers, 1);
+    auto const report = [&](std::string_view name, size_t threads, double created, double elapsed, size_t memory,
+                            uint64_t switches) {
+        std::cout << name << ": " << instances << " instances on " << threads << " threads, created in " << created
+                  << " s, " << memory / 1024 << " MiB resident, "
+                  << static_cast<double>(instances * (inputs + S_LEN + 1)) / elapsed << " inputs/s, " << switches
+                  << " context switches\n";
+    };
+
+    {
+        auto const memory = residentKiB();
+        auto const start = std::chrono::steady_clock::now();
+        std::vector<std::unique_ptr<ThreadLights>> fleet;
+        fleet.reserve(instances);
+        for (size_t i = 0; i < instances; ++i) {
+            fleet.push_back(std::make_unique<ThreadLights>());
+        }
+        auto const created = std::chrono::steady_clock::now();
+        auto const switches = contextSwitches();
+        postInputs(instances, inputs, producers, [&fleet](size_t id, std::span<uint32_t const> chunk) {
+            fleet[id]->processInputs(chunk);
+        });
+        auto const resident = residentKiB() - std::min(memory, residentKiB());
+        // the worker threads process all queued inputs before they terminate
+        fleet.clear();
+        auto const end = std::chrono::steady_clock::now();
+        report("threads", instances, std::chrono::duration<double>{created - start}.count(),
+               std::chrono::duration<double>{end - created}.count(), resident, contextSwitches() - switches);
+    }
+
+    {
+        auto const memory = residentKiB();
+        auto const start = std::chrono::steady_clock::now();
+        ShardedRuntime runtime{instances, shards};
+        auto const created = std::chrono::steady_clock::now();
+        auto const switches = contextSwitches();
+        postInputs(instances, inputs, producers, [&runtime](size_t id, std::span<uint32_t const> chunk) {
+            runtime.post(id, chunk);
+        });
+        runtime.drain();
+        auto const end = std::chrono::steady_clock::now();
+        auto const resident = residentKiB() - std::min(memory, residentKiB());
+        report("shards", runtime.shards(), std::chrono::duration<double>{created - start}.count(),
+               std::chrono::duration<double>{end - created}.count(), resident, contextSwitches() - switches);
+
+        uint64_t checksum = 0;
+        for (ShardedRuntime::Id id = 0; id < runtime.size(); ++id) {
+            checksum += runtime[id].getLights();
+        }
+        auto const stats = runtime.stats();
+        std::cout << "shards: " << stats.batches << " batches, " << stats.parks << " worker parks, " << stats.waits
+                  << " producer waits, lights checksum " << checksum << "\n";
+    }
+    printStats();
+}
+
+/**
+ * Write the INIT inputs of `initLights` for every one of `instances` instances to `writer`, followed by `inputs` RUN
+ * inputs per instance, interleaved in chunks. Writers that buffer inputs are flushed after each round of chunks.
+ */
+template <typename Writer>
+void writeInputs(Writer& writer, uint32_t instances, size_t inputs) {
+    constexpr size_t CHUNK = 64;
+    std::array<uint32_t, S_LEN + 1> const init{S_LEN, OFF, RED, GREEN, YELLOW, RED | YELLOW};
+    std::array<uint32_t, CHUNK> chunk{};
+
+    for (uint32_t instance = 0; instance < instances; ++instance) {
+        writer.write(instance, init);
+    }
+    for (size_t k = 0; k < inputs; k += CHUNK) {
+        auto const count = std::min(CHUNK, inputs - k);
+        for (uint32_t instance = 0; instance < instances; ++instance) {
+            for (size_t i = 0; i < count; ++i) {
+                chunk.at(i) = static_cast<uint32_t>((instance + k + i) % S_LEN);
+            }
+            writer.write(instance, std::span<uint32_t const>{chunk}.first(count));
+        }
+        if constexpr (requires { writer.flush(); }) {
+            writer.flush();
+        }
+    }
+    writer.close();
+}
+
+/// Write a trace of `writeInputs` for `instances` instances to `path`.
+void writeTrace(std::string const& path, uint32_t instances, size_t inputs) {
+    TraceWriter writer{path, instances};
+    writeInputs(writer, instances, inputs);
+
+    std::cout << "trace: " << instances << " instances, " << inputs << " inputs each, written to " << path << "\n";
+}
+
+/// Replay `trace` on one instance of `L` per traced instance, report the throughput.
+template <LightsType L>
+void replayTrace(TraceReader const& trace) {
+    std::vector<L> fleet(trace.header().instances);
+
+    auto const start = std::chrono::steady_clock::now();
+    trace.forEach([&fleet](uint32_t instance, std::span<uint32_t const> inputs) {
+        fleet[instance].processInputs(inputs);
+    });
+    std::chrono::duration<double> const elapsed = std::chrono::steady_clock::now() - start;
+
+    auto const inputs = static_cast<double>(trace.header().inputs);
+    std::cout << "replay: " << trace.header().instances << " instances, " << trace.header().inputs << " inputs in "
+              << trace.header().blocks << " blocks, " << elapsed.count() << " s, " << inputs / elapsed.count()
+              << " inputs/s, " << static_cast<double>(trace.bytes()) / elapsed.count() / 1e9 << " GB/s\n";
+}
+
+/// Replay the trace at `path` on the implementation named `implementation`.
+void runReplay(std::string const& path, std::string_view implementation) {
+    Lights::setDefaultSink(nullptr);
+
+    TraceReader const trace{path};
+    if (implementation == "state-machine") {
+        replayTrace<StateMachineLights>(trace);
+    } else if (implementation == "co-routine") {
+        replayTrace<CoRoutineLights>(trace);
+    } else if (implementation == "thread") {
+        replayTrace<ThreadLights>(trace);
+    } else if (implementation == "fiber") {
+        replayTrace<FiberLights>(trace);
+    } else {
+        throw std::invalid_argument{"Unknown implementation " + std::string{implementation}};
+    }
+    // after the instances are destroyed, so that threads have processed all inputs
+    printStats();
+}
+
+/**
+ * Drive one instance of `L` per instance of `ring` with the inputs published to it, straight from the shared memory,
+ * until the producer closes the ring. Report the throughput.
+ */
+template <LightsType L>
+void consumeRing(ShmRingReader& ring) {
+    std::vector<L> fleet(ring.instances());
+
+    size_t inputs = 0;
+    size_t polls = 0;
+    std::optional<std::chrono::steady_clock::time_point> start;
+    while (ring.wait()) {
+        if (!start) {
+            start = std::chrono::steady_clock::now();
+        }
+        inputs += ring.poll([&fleet](uint32_t instance, std::span<uint32_t const> block) {
+            fleet[instance].processInputs(block);
+        });
+        ++polls;
+    }
+    auto const end = std::chrono::steady_clock::now();
+    std::chrono::duration<double> const elapsed = end - start.value_or(end);
+    std::cout << "shm: " << fleet.size() << " instances, " << inputs << " inputs in " << polls << " polls, "
+              << elapsed.count() << " s, " << static_cast<double>(inputs) / elapsed.count() << " inputs/s\n";
+}
+
+/// Create the input ring `name` for `instances` instances and drive the implementation named `implementation` with it.
+void runShm(std::string const& name, std::string_view implementation, uint32_t instances, size_t capacity) {
+    Lights::setDefaultSink(nullptr);
+
+    ShmRingReader ring{name, instances, capacity};
+    std::cout << "shm: waiting for inputs on " << name << "\n" << std::flush;
+    if (implementation == "state-machine") {
+        consumeRing<StateMachineLights>(ring);
+    } else if (implementation == "co-routine") {
+        consumeRing<CoRoutineLights>(ring);
+    } else if (implementation == "thread") {
+        consumeRing<ThreadLights>(ring);
+    } else if (implementation == "fiber") {
+        consumeRing<FiberLights>(ring);
+    } else {
+        throw std::invalid_argument{"Unknown implementation " + std::string{implementation}};
+    }
+    printStats();
+}
+
+/// Attach to the input ring `name` and publish the inputs of `writeInputs` to it, as a stand-in for a real producer.
+void feedShm(std::string const& name, size_t inputs) {
+    ShmRingWriter writer{name};
+    auto const start = std::chrono::steady_clock::now();
+    writeInputs(writer, writer.instances(), inputs);
+    std::chrono::duration<double> const elapsed = std::chrono::steady_clock::now() - start;
+
+    auto const total = static_cast<double>(writer.instances()) * static_cast<double>(inputs + S_LEN + 1);
+    std::cout << "shm-feed: " << writer.instances() << " instances, " << inputs << " inputs each, " << elapsed.count()
+              << " s, " << total / elapsed.count() << " inputs/s\n";
+}
+
+/// Raise the limit of open descriptors to the hard limit, so that a process can hold tens of thousands of connections.
+void raiseFileLimit() {
+    rlimit limit{};
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+}
+
+/**
+ * Serve co-routine lights over the Unix domain socket `path` until `connections` connections were opened and closed
+ * again, and report the throughput and the number of connections served at the same time.
+ */
+void runServer(std::string const& path, size_t connections) {
+    Lights::setDefaultSink(nullptr);
+    raiseFileLimit();
+
+    LightsServer server{path};
+    std::cout << "serve: listening on " << path << "\n" << std::flush;
+    std::optional<std::chrono::steady_clock::time_point> start;
+    double cpuStart = 0;
+    while (server.stats().closed < connections) {
+        server.runOnce(std::chrono::milliseconds{100});
+        if (!start && server.stats().opened > 0) {
+            start = std::chrono::steady_clock::now();
+            cpuStart = threadCpuSeconds();
+        }
+    }
+    auto const end = std::chrono::steady_clock::now();
+    std::chrono::duration<double> const elapsed = end - start.value_or(end);
+    auto const cpu = threadCpuSeconds() - cpuStart;
+
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    auto const& stats = server.stats();
+    std::cout << "serve: " << stats.closed << " connections, " << stats.peak << " at the same time, " << stats.frames
+              << " frames, " << stats.inputs << " inputs, " << elapsed.count() << " s, "
+              << static_cast<double>(stats.inputs) / elapsed.count() << " inputs/s, " << cpu << " s CPU, "
+              << usage.ru_maxrss << " kB peak RSS, " << stats.rejected << " rejected, lights checksum " << stats.lights
+              << "\n";
+    printStats();
+}
+
+/**
+ * Open `connections` connections to the server at `path` and send the INIT inputs of `initLights` on each, followed by
+ * `frames` frames of RUN inputs, interleaved. Report the throughput and the lights checksum the server should report.
+ */
+void runClient(std::string const& path, size_t connections, size_t frames) {
+    Lights::setDefaultSink(nullptr);
+    raiseFileLimit();
+    constexpr uint32_t CHUNK = 16;
+
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) {
+        throw std::invalid_argument{"Socket path too long: " + path};
+    }
+    std::copy(path.begin(), path.end(), std::begin(address.sun_path));
+
+    // send whole frames, blocking while the server catches up
+    auto const send = [](int fd, std::span<uint32_t const> frame) {
+        auto const bytes = std::as_bytes(frame);
+        for (size_t sent = 0; sent < bytes.size();) {
+            auto const count = write(fd, bytes.subspan(sent).data(), bytes.size() - sent);
+            if (count < 0 && errno != EINTR) {
+                throw std::system_error{errno, std::generic_category(), "write"};
+            }
+            sent += static_cast<size_t>(std::max<ssize_t>(count, 0));
+        }
+    };
+
+    // the server runs the same inputs on co-routine lights, state machine lights tell which lights it should end with
+    std::vector<int> sockets;
+    std::vector<StateMachineLights> expected(connections);
+    auto const start = std::chrono::steady_clock::now();
+    std::array<uint32_t, S_LEN + 2> const init{S_LEN + 1, S_LEN, OFF, RED, GREEN, YELLOW, RED | YELLOW};
+    for (size_t c = 0; c < connections; ++c) {
+        auto const fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast): socket API
+        if (fd < 0 || connect(fd, reinterpret_cast<sockaddr const*>(&address), sizeof(address)) != 0) {
+            auto const error = errno;
+            std::for_each(sockets.begin(), sockets.end(), close);
+            throw std::system_error{error, std::generic_category(), "connect " + path};
+        }
+        sockets.push_back(fd);
+        send(fd, init);
+        expected[c].processInputs(std::span<uint32_t const>{init}.subspan(1));
+    }
+    auto const connected = std::chrono::steady_clock::now();
+
+    std::array<uint32_t, CHUNK + 1> frame{CHUNK};
+    for (size_t k = 0; k < frames; ++k) {
+        for (size_t c = 0; c < connections; ++c) {
+            for (size_t i = 0; i < CHUNK; ++i) {
+                frame.at(i + 1) = static_cast<uint32_t>((c + k * CHUNK + i) % S_LEN);
+            }
+            send(sockets[c], frame);
+            expected[c].processInputs(std::span<uint32_t const>{frame}.subspan(1));
+        }
+    }
+    std::for_each(sockets.begin(), sockets.end(), close);
+    auto const end = std::chrono::steady_clock::now();
+
+    uint64_t checksum = 0;
+    for (auto const& lights : expected) {
+        checksum += lights.getLights();
+    }
+    std::chrono::duration<double> const connecting = connected - start;
+    std::chrono::duration<double> const sending = end - connected;
+    auto const inputs = static_cast<double>(connections * frames * CHUNK);
+    std::cout << "connect: " << connections << " connections in " << connecting.count() << " s, " << frames
+              << " frames of " << CHUNK << " inputs each, " << sending.count() << " s, " << inputs / sending.count()
+              << " inputs/s, expected lights checksum " << checksum << "\n";
+}
+
+/**
+ * Initialize `instances` state machine lights with one of a few configurations each, drive them through some RUN
+ * inputs and write a snapshot of their states to `path`.
+ */
+void writeSnapshot(std::string const& path, size_t instances) {
+    Lights::setDefaultSink(nullptr);
+
+    constexpr size_t CONFIGURATIONS = 4;
+    std::vector<StateMachineLights> fleet(instances);
+    auto const start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < instances; ++i) {
+        // configurations differ in the number of states
+        auto const len = static_cast<uint32_t>(S_LEN - (i % CONFIGURATIONS));
+        std::array<uint32_t, S_LEN + 1> const init{len, OFF, RED, GREEN, YELLOW, RED | YELLOW};
+        fleet[i].processInputs(std::span<uint32_t const>{init}.first(len + 1));
+        fleet[i].processInput(static_cast<uint32_t>(i % len));
+    }
+    std::chrono::duration<double> const initialized = std::chrono::steady_clock::now() - start;
+
+    SnapshotWriter writer{path};
+    for (auto const& lights : fleet) {
+        writer.add(lights);
+    }
+    writer.close();
+    std::chrono::duration<double> const written = std::chrono::steady_clock::now() - start - initialized;
+
+    std::cout << "snapshot: " << instances << " instances initialized in " << initialized.count() << " s, written to "
+              << path << " in " << written.count() << " s\n";
+}
+
+/// Restore one instance of `L` per instance in `snapshot`, report the time taken.
+template <LightsType L>
+void restoreSnapshot(SnapshotReader const& snapshot) {
+    auto const start = std::chrono::steady_clock::now();
+    std::vector<L> fleet(snapshot.size());
+    auto const constructed = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < fleet.size(); ++i) {
+        snapshot.restore(i, fleet[i]);
+    }
+    auto const restored = std::chrono::steady_clock::now();
+
+    uint64_t checksum = 0;
+    for (auto const& lights : fleet) {
+        checksum += lights.getLights();
+    }
+    std::chrono::duration<double> const construction = constructed - start;
+    std::chrono::duration<double> const restore = restored - constructed;
+    std::cout << "restore: " << fleet.size() << " instances, " << snapshot.tables() << " tables, construction "
+              << construction.count() << " s, restore " << restore.count() << " s, "
+              << restore.count() * 1e9 / static_cast<double>(std::max<size_t>(fleet.size(), 1))
+              << " ns per instance, lights checksum " << checksum << "\n";
+}
+
+/// Restore the snapshot at `path` on the implementation named `implementation`.
+void runRestore(std::string const& path, std::string_view implementation) {
+    Lights::setDefaultSink(nullptr);
+
+    auto const start = std::chrono::steady_clock::now();
+    SnapshotReader const snapshot{path};
+    std::chrono::duration<double> const loaded = std::chrono::steady_clock::now() - start;
+    std::cout << "restore: " << path << " mapped and validated in " << loaded.count() << " s\n";
+
+    if (implementation == "state-machine") {
+        restoreSnapshot<StateMachineLights>(snapshot);
+    } else if (implementation == "co-routine") {
+        restoreSnapshot<CoRoutineLights>(snapshot);
+    } else if (implementation == "thread") {
+        restoreSnapshot<ThreadLights>(snapshot);
+    } else if (implementation == "fiber") {
+        restoreSnapshot<FiberLights>(snapshot);
+    } else {
+        throw std::invalid_argument{"Unknown implementation " + std::string{implementation}};
+    }
+}
+
+/// Print usage information.
+void usage(std::string_view name) {
+    std::cerr << "Usage: " << name << " [MODE]\n"
+              << "Modes:\n"
+              << "  demo                          run the input script on each implementation (default)\n"
+              << "  executor [INSTANCES] [INPUTS] drive co-routine lights through the executor loop\n"
+              << "  pool [INSTANCES] [INPUTS] [THREADS]\n"
+              << "                                scale co-routine lights on a work-stealing pool from 1 to THREADS\n"
+              << "  frames [INSTANCES] [ROUNDS]   create and destroy co-routine lights, count global heap allocations\n"
+              << "  graph [NODES] [INPUTS]        propagate inputs through a tree of connected lights\n"
+              << "  timers [INSTANCES] [SECONDS]  simulate timed lights cycling through their phases on one thread\n"
+              << "  changes [INPUTS]              await transitions instead of polling the lights\n"
+              << "  monitor [INSTANCES] [ROUNDS] [READERS]\n"
+              << "                                poll the lights of many instances from reader threads\n"
+              << "  plans [INSTANCES] [ROUNDS] [PLANS]\n"
+              << "                                replace the timing plan shared by many instances while they run\n"
+              << "  shards [INSTANCES] [INPUTS] [SHARDS] [PRODUCERS]\n"
+              << "                                compare a thread per instance with fibers on pinned shard threads\n"
+              << "  trace FILE [INSTANCES] [INPUTS] write a synthetic input trace\n"
+              << "  replay FILE [IMPLEMENTATION]  replay a trace on state-machine (default), co-routine, thread or\n"
+              << "                                fiber lights\n"
+              << "  shm NAME [IMPLEMENTATION] [INSTANCES] [CAPACITY]\n"
+              << "                                create a shared memory input ring and drive lights with its inputs\n"
+              << "  shm-feed NAME [INPUTS]        publish synthetic inputs to a shared memory input ring\n"
+              << "  serve SOCKET [CONNECTIONS]    serve co-routine lights over a Unix domain socket until CONNECTIONS\n"
+              << "                                connections were served\n"
+              << "  connect SOCKET [CONNECTIONS] [FRAMES]\n"
+              << "                                send frames of inputs to a server over many connections\n"
+              << "  snapshot FILE [INSTANCES]     initialize state machine lights and write a snapshot of them\n"
+              << "  restore FILE [IMPLEMENTATION] restore a snapshot on state-machine (default), co-routine, thread\n"
+              << "                                or fiber lights\n";
+}
+
+int main(int argc, char* argv[]) {
+    std::span<char*> const args{argv, static_cast<size_t>(argc)};
+    std::string_view const mode = args.size() > 1 ? args[1] : "demo";
+
+    try {
+        if (mode == "demo") {
+            runDemo();
+        } else if (mode == "executor") {
+            auto const instances = args.size() > 2 ? std::stoul(args[2]) : 100'000UL;
+            auto const inputs = args.size() > 3 ? std::stoul(args[3]) : 100UL;
+            runExecutor(instances, inputs);
+        } else if (mode == "pool") {
+            auto const instances = args.size() > 2 ? std::stoul(args[2]) : 100'000UL;
+            auto const inputs = args.size() > 3 ? std::stoul(args[3]) : 100UL;
+            auto const threads = args.size() > 4 ? std::stoul(args[4]) : std::thread::hardware_concurrency();
+            runPool(instances, inputs, threads);
+        } else if (mode == "frames") {
+            auto const instances = args.size() > 2 ? std::stoul(args[2]) : 100'000UL;
+            auto const rounds = args.size() > 3 ? std::stoul(args[3]) : 5UL;
+            runFrames(instances, rounds);
+        } else if (mode == "graph") {
+            auto const nodes = args.size() > 2 ? std::stoul(args[2]) : 10'000UL;
+            auto const inputs = args.size() > 3 ? std::stoul(args[3]) : 1'000UL;
+            runGraph(nodes, inputs);
+        } else if (mode == "timers") {
+            auto const instances = args.size() > 2 ? std::stoul(args[2]) : 1'000'000UL;
+            auto const seconds = args.size() > 3 ? std::stoul(args[3]) : 3'600UL;
+            runTimers(instances, seconds);
+        } else if (mode == "changes") {
+            auto const inputs = args.size() > 2 ? std::stoul(args[2]) : 1'000'000UL;
+            runChanges(inputs);
+        } else if (mode == "monitor") {
+            auto const instances = args.size() > 2 ? std::stoul(args[2]) : 10'000UL;
+            auto const rounds = args.size() > 3 ? std::stoul(args[3]) : 1'000UL;
+            auto const readers = args.size() > 4 ? std::stoul(args[4]) : 4UL;
+            runMonitor(instances, rounds, readers);
+        } else if (mode == "plans") {
+            auto const instances = args.size() > 2 ? std::stoul(args[2]) : 10'000UL;
+            auto const rounds = args.size() > 3 ? std::stoul(args[3]) : 1'000UL;
+            auto const plans = args.size() > 4 ? std::stoul(args[4]) : 10'000UL;
+            runPlans(instances, rounds, plans);
+        } else if (mode == "shards") {
+            auto const instances = args.size() > 2 ? std::stoul(args[2]) : 10'000UL;
+            auto const inputs = args.size() > 3 ? std::stoul(args[3]) : 100UL;
+            auto const shards = args.size() > 4 ? std::stoul(args[4]) : std::thread::hardware_concurrency();
+            auto const producers = args.size() > 5 ? std::stoul(args[5]) : 1UL;
+            runShards(instances, inputs, shards, producers);
+        } else if (mode == "trace" && args.size() > 2) {
+            auto const instances = args.size() > 3 ? std::stoul(args[3]) : 1'000UL;
+            auto const inputs = args.size() > 4 ? std::stoul(args[4]) : 10'000UL;
+            writeTrace(args[2], static_cast<uint32_t>(instances), inputs);
+        } else if (mode == "replay" && args.size() > 2) {
+            runReplay(args[2], args.size() > 3 ? args[3] : "state-machine");
+        } else if (mode == "shm" && args.size() > 2) {
+            auto const instances = args.size() > 4 ? std::stoul(args[4]) : 1'000UL;
+            auto const capacity = args.size() > 5 ? std::stoul(args[5]) : ShmRingReader::DEFAULT_CAPACITY;
+            runShm(args[2], args.size() > 3 ? args[3] : "state-machine", static_cast<uint32_t>(instances), capacity);
+        } else if (mode == "shm-feed" && args.size() > 2) {
+            auto const inputs = args.size() > 3 ? std::stoul(args[3]) : 10'000UL;
+            feedShm(args[2], inputs);
+        } else if (mode == "serve" && args.size() > 2) {
+            auto const connections = args.size() > 3 ? std::stoul(args[3]) : 10'000UL;
+            runServer(args[2], connections);
+        } else if (mode == "connect" && args.size() > 2) {
+            auto const connections = args.size() > 3 ? std::stoul(args[3]) : 10'000UL;
+            auto const frames = args.size() > 4 ? std::stoul(args[4]) : 100UL;
+            runClient(args[2], connections, frames);
+        } else if (mode == "snapshot" && args.size() > 2) {
+            auto const instances = args.size() > 3 ? std::stoul(args[3]) : 1'000'000UL;
+            writeSnapshot(args[2], instances);
+        } else if (mode == "restore" && args.size() > 2) {
+            runRestore(args[2], args.size() > 3 ? args[3] : "state-machine");
+        } else {
+            usage(args[0]);
+            return 1;
+        }
+    } catch (std::exception const& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        usage(args[0]);
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,650 @@
+#include <malloc.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "CoRoutineLights.hpp"
+#include "Fiber.hpp"
+#include "FiberLights.hpp"
+#include "Lights.hpp"
+#include "LightsBank.hpp"
+#include "LightsVariant.hpp"
+#include "StateMachineLights.hpp"
+#include "StackPool.hpp"
+#include "StaticLights.hpp"
+#include "Task.hpp"
+#include "ThreadLights.hpp"
+
+namespace {
+
+/// Benchmark configuration, set from the command line.
+struct Config {
+    /// number of instances for construction, destruction and memory measurements
+    size_t instances{1'000};
+    /// length of the generated RUN input stream
+    size_t inputs{1'000'000};
+    /// seed for the input stream generator
+    uint32_t seed{1};
+    /// inputs per call in the batched throughput measurement
+    size_t batch{1'024};
+    /// output format, `csv` or `json`
+    std::string format{"csv"};
+    /// only run implementations whose name contains this
+    std::string filter{};
+};
+
+/// One measurement.
+struct Result {
+    std::string implementation;
+    std::string metric;
+    double value;
+    std::string unit;
+};
+
+/// Lights with a state table fixed at compile time, the table of every implementation.
+using BenchStaticLights = StaticLights<0, 1, 2, 4, 6>;
+
+/// The input streams fed to every implementation.
+struct Workload {
+    /// INIT phase inputs: number of states followed by the states of `BenchStaticLights`
+    std::vector<uint32_t> init;
+    /// RUN phase inputs, including some out of bounds inputs
+    std::vector<uint32_t> run;
+};
+
+/**
+ * Generate the workload, identical for all implementations given the same configuration.
+ *
+ * The states are those of `BenchStaticLights`, so that the implementations initialized by INIT inputs run with the same
+ * table as the one fixed at compile time; only the RUN inputs depend on the seed.
+ */
+Workload generate(Config const& config) {
+    constexpr auto STATES = static_cast<uint32_t>(BenchStaticLights::STATES.size());
+    constexpr uint32_t OUT_OF_BOUNDS_RANGE = 8;
+
+    std::mt19937 engine{config.seed};
+    Workload workload{};
+    workload.init.push_back(STATES);
+    workload.init.insert(workload.init.end(), BenchStaticLights::STATES.begin(), BenchStaticLights::STATES.end());
+    std::uniform_int_distribution<uint32_t> distribution{0, STATES + OUT_OF_BOUNDS_RANGE - 1};
+    workload.run.reserve(config.inputs);
+    for (size_t i = 0; i < config.inputs; ++i) {
+        // mostly valid states, some out of bounds
+        auto const input = distribution(engine);
+        workload.run.push_back(input < STATES + 1 ? input : input % STATES);
+    }
+    return workload;
+}
+
+/// True if results of implementation `name` are selected by `--filter`.
+bool selected(Config const& config, std::string_view name) {
+    return name.find(config.filter) != std::string_view::npos;
+}
+
+/// Resident set size of this process in bytes, read from `/proc/self/statm`.
+size_t residentBytes() {
+    std::ifstream statm{"/proc/self/statm"};
+    size_t pages{};
+    size_t resident{};
+    statm >> pages >> resident;
+    return resident * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+}
+
+/**
+ * Bytes allocated from the global heap, excluding memory cached by `malloc`. Includes the chunks of the frame pool,
+ * which come from the global heap, so frames allocated from chunks that are already there are not counted.
+ */
+size_t heapBytes() {
+    return mallinfo2().uordblks;
+}
+
+/// Return the value at quantile `q` of sorted `values`.
+double quantile(std::vector<double> const& sorted, double q) {
+    auto const index = static_cast<size_t>(q * static_cast<double>(sorted.size() - 1));
+    return sorted[index];
+}
+
+/// Feed the INIT phase inputs to `lights`, unless its table is fixed at compile time.
+template <typename L>
+void initialize(L& lights, Workload const& workload) {
+    if constexpr (!std::is_same_v<L, BenchStaticLights>) {
+        lights.processInputs(workload.init);
+    }
+}
+
+using Clock = std::chrono::steady_clock;
+using Nanoseconds = std::chrono::duration<double, std::nano>;
+
+/**
+ * Run all measurements for implementation `L`.
+ *
+ * Every measurement uses fresh instances, so that they do not influence each other. Throughput of `ThreadLights`
+ * includes the time to drain the queue (the destructor joins the worker after all queued inputs are processed).
+ */
+template <typename L>
+void bench(std::string const& name, Config const& config, Workload const& workload, std::vector<Result>& results) {
+    if (!selected(config, name)) {
+        return;
+    }
+    auto const inputs = static_cast<double>(workload.run.size());
+
+    // latency of individual processInput calls
+    {
+        std::vector<double> latencies(workload.run.size());
+        auto lights = std::make_unique<L>();
+        initialize(*lights, workload);
+        for (size_t i = 0; i < workload.run.size(); ++i) {
+            auto const start = Clock::now();
+            lights->processInput(workload.run[i]);
+            latencies[i] = Nanoseconds{Clock::now() - start}.count();
+        }
+        lights.reset();
+        std::sort(latencies.begin(), latencies.end());
+        constexpr double P50 = 0.5;
+        constexpr double P99 = 0.99;
+        constexpr double P999 = 0.999;
+        results.push_back({name, "latency_p50", quantile(latencies, P50), "ns"});
+        results.push_back({name, "latency_p99", quantile(latencies, P99), "ns"});
+        results.push_back({name, "latency_p999", quantile(latencies, P999), "ns"});
+    }
+
+    // sustained throughput, one input per call
+    {
+        auto lights = std::make_unique<L>();
+        initialize(*lights, workload);
+        auto const start = Clock::now();
+        for (auto input : workload.run) {
+            lights->processInput(input);
+        }
+        lights.reset();
+        std::chrono::duration<double> const elapsed = Clock::now() - start;
+        results.push_back({name, "throughput", inputs / elapsed.count(), "inputs/s"});
+    }
+
+    // sustained throughput, batches of inputs per call
+    {
+        auto lights = std::make_unique<L>();
+        initialize(*lights, workload);
+        std::span<uint32_t const> const run{workload.run};
+        auto const start = Clock::now();
+        for (size_t i = 0; i < run.size(); i += config.batch) {
+            lights->processInputs(run.subspan(i, std::min(config.batch, run.size() - i)));
+        }
+        lights.reset();
+        std::chrono::duration<double> const elapsed = Clock::now() - start;
+        results.push_back({name, "throughput_batched", inputs / elapsed.count(), "inputs/s"});
+    }
+
+    // construction, initialization, resident memory and destruction of many instances
+    {
+        auto const count = static_cast<double>(config.instances);
+        std::vector<std::unique_ptr<L>> fleet{};
+        fleet.reserve(config.instances);
+        auto const heapBefore = heapBytes();
+        auto const rssBefore = residentBytes();
+
+        auto start = Clock::now();
+        for (size_t i = 0; i < config.instances; ++i) {
+            fleet.push_back(std::make_unique<L>());
+        }
+        results.push_back({name, "construction", Nanoseconds{Clock::now() - start}.count() / count, "ns"});
+
+        start = Clock::now();
+        for (auto& lights : fleet) {
+            initialize(*lights, workload);
+        }
+        results.push_back({name, "initialization", Nanoseconds{Clock::now() - start}.count() / count, "ns"});
+
+        // resident memory includes thread stacks but misses memory re-used from earlier measurements, heap memory is
+        // exact for allocations but misses thread stacks
+        auto const rssAfter = residentBytes();
+        auto const heapAfter = heapBytes();
+        auto const rssDelta = rssAfter > rssBefore ? rssAfter - rssBefore : 0;
+        auto const heapDelta = heapAfter > heapBefore ? heapAfter - heapBefore : 0;
+        results.push_back({name, "memory_rss", static_cast<double>(rssDelta) / count, "bytes"});
+        results.push_back({name, "memory_heap", static_cast<double>(heapDelta) / count, "bytes"});
+
+        start = Clock::now();
+        fleet.clear();
+        results.push_back({name, "destruction", Nanoseconds{Clock::now() - start}.count() / count, "ns"});
+    }
+}
+
+/// Time `function` and return the throughput in inputs per second.
+template <typename F>
+double throughput(size_t inputs, F&& function) {
+    auto const start = Clock::now();
+    std::forward<F>(function)();
+    std::chrono::duration<double> const elapsed = Clock::now() - start;
+    return static_cast<double>(inputs) / elapsed.count();
+}
+
+/**
+ * Compare bulk simulation of `config.instances` instances in a `LightsBank` with per-object virtual calls on
+ * `StateMachineLights` objects.
+ *
+ * Dense ticks apply one input to every instance, sparse events address random instances. Both use the RUN inputs of
+ * the workload.
+ */
+void benchBank(Config const& config, Workload const& workload, std::vector<Result>& results) {
+    // the rows of each side are selected by the name of their implementation
+    auto const bankSelected = selected(config, "LightsBank");
+    auto const objectsSelected = selected(config, "StateMachineLights");
+    if (!bankSelected && !objectsSelected) {
+        return;
+    }
+    auto const instances = std::max<size_t>(config.instances, 1);
+    auto const ticks = std::max<size_t>(workload.run.size() / instances, 1);
+    auto const table = std::span<uint32_t const>{workload.init}.subspan(1);
+
+    std::vector<uint32_t> stream(ticks * instances);
+    std::vector<LightsBank::Event> events(ticks * instances);
+    std::mt19937 engine{config.seed};
+    for (size_t i = 0; i < stream.size(); ++i) {
+        stream[i] = workload.run[i % workload.run.size()];
+        events[i] = {static_cast<LightsBank::Id>(engine() % instances), stream[i]};
+    }
+
+    LightsBank bank{table.size()};
+    std::vector<std::unique_ptr<Lights>> objects{};
+    for (size_t i = 0; i < instances; ++i) {
+        bank.add(table);
+        objects.push_back(std::make_unique<StateMachineLights>());
+        objects.back()->processInputs(workload.init);
+    }
+
+    if (bankSelected) {
+        results.push_back({"LightsBank", "throughput_tick", throughput(stream.size(), [&]() {
+                               for (size_t k = 0; k < ticks; ++k) {
+                                   bank.tick(std::span<uint32_t const>{stream}.subspan(k * instances, instances));
+                               }
+                           }),
+                           "inputs/s"});
+    }
+    if (objectsSelected) {
+        results.push_back({"StateMachineLights", "throughput_tick", throughput(stream.size(), [&]() {
+                               for (size_t k = 0; k < ticks; ++k) {
+                                   for (size_t i = 0; i < instances; ++i) {
+                                       objects[i]->processInput(stream[(k * instances) + i]);
+                                   }
+                               }
+                           }),
+                           "inputs/s"});
+    }
+    if (bankSelected) {
+        results.push_back({"LightsBank", "throughput_events",
+                           throughput(events.size(), [&]() { bank.apply(events); }), "inputs/s"});
+    }
+    if (objectsSelected) {
+        results.push_back({"StateMachineLights", "throughput_events", throughput(events.size(), [&]() {
+                               for (auto const& event : events) {
+                                   objects[event.instance]->processInput(event.input);
+                               }
+                           }),
+                           "inputs/s"});
+    }
+}
+
+/// Feed `inputs` one by one through the virtual interface, not inlined so that the call cannot be devirtualized.
+[[gnu::noinline]] void feedVirtual(Lights& lights, std::span<uint32_t const> inputs) {
+    for (auto input : inputs) {
+        lights.processInput(input);
+    }
+}
+
+/// Feed `inputs` one by one to the concrete type, calls are resolved at compile time.
+template <LightsType L>
+[[gnu::noinline]] void feedStatic(L& lights, std::span<uint32_t const> inputs) {
+    for (auto input : inputs) {
+        lights.processInput(input);
+    }
+}
+
+/// Feed `inputs` one by one through `std::visit`.
+[[gnu::noinline]] void feedVariant(LightsVariant& lights, std::span<uint32_t const> inputs) {
+    for (auto input : inputs) {
+        processInput(lights, input);
+    }
+}
+
+/// True if `L` is one of the alternatives of `LightsVariant`.
+template <typename L, typename Variant = LightsVariant>
+struct IsLightsAlternative;
+
+template <typename L, typename... Alternatives>
+struct IsLightsAlternative<L, std::variant<Alternatives...>>
+    : std::bool_constant<(std::is_same_v<L, Alternatives> || ...)> {};
+
+/**
+ * Compare virtual dispatch, static dispatch and `std::variant` dispatch of `processInput` for implementation `L`; the
+ * latter only if `L` is an alternative of `LightsVariant`.
+ *
+ * The difference of the per-input times is the dispatch overhead. Static dispatch only saves more than the indirect
+ * call if `processInput` can be inlined, i.e., if it is defined in the header like the one of `StaticLights`; for
+ * implementations defining it out of line, the static call is a direct call to the same function.
+ */
+template <typename L>
+void benchDispatch(std::string const& name, Config const& config, Workload const& workload,
+                   std::vector<Result>& results) {
+    if (!selected(config, name)) {
+        return;
+    }
+    auto const perInput = [&](auto&& feed) {
+        auto const start = Clock::now();
+        feed();
+        return Nanoseconds{Clock::now() - start}.count() / static_cast<double>(workload.run.size());
+    };
+
+    L concrete{};
+    initialize(concrete, workload);
+    results.push_back({name, "dispatch_virtual", perInput([&]() { feedVirtual(concrete, workload.run); }), "ns"});
+    results.push_back({name, "dispatch_static", perInput([&]() { feedStatic(concrete, workload.run); }), "ns"});
+
+    if constexpr (IsLightsAlternative<L>::value) {
+        LightsVariant variant{std::in_place_type<L>};
+        processInputs(variant, workload.init);
+        results.push_back({name, "dispatch_variant", perInput([&]() { feedVariant(variant, workload.run); }), "ns"});
+    }
+}
+
+/// Co-routine suspending forever, each resume runs one iteration.
+struct PingPong {
+    struct promise_type {
+        PingPong get_return_object() noexcept {
+            return {std::coroutine_handle<promise_type>::from_promise(*this)};
+        }
+        static std::suspend_always initial_suspend() noexcept {
+            return {};
+        }
+        static std::suspend_always final_suspend() noexcept {
+            return {};
+        }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept {}
+    };
+
+    std::coroutine_handle<promise_type> handle;
+};
+
+/// Loop suspending in every iteration.
+PingPong pingPong() {
+    while (true) {
+        co_await std::suspend_always{};
+    }
+}
+
+/**
+ * Measure the cost of switching into a task and back, which is the minimum cost of handing an input to a waiting
+ * instance: resume and suspend of a fiber (`FiberLights`) and of a stackless co-routine (`CoRoutineLights`), and a
+ * round trip between two kernel threads blocking on an atomic (`ThreadLights`).
+ */
+void benchSwitch(Config const& config, std::vector<Result>& results) {
+    auto const perSwitch = [](size_t count, auto&& roundTrip) {
+        auto const start = Clock::now();
+        for (size_t i = 0; i < count; ++i) {
+            roundTrip();
+        }
+        return Nanoseconds{Clock::now() - start}.count() / static_cast<double>(count);
+    };
+
+    if (selected(config, "FiberLights")) {
+        Fiber* self{};
+        Fiber fiber{[](void* fiber) {
+                        while (true) {
+                            (*static_cast<Fiber**>(fiber))->suspend();
+                        }
+                    },
+                    static_cast<void*>(&self)};
+        self = &fiber;
+        results.push_back({"FiberLights", "context_switch", perSwitch(config.inputs, [&]() { fiber.resume(); }), "ns"});
+        // the fiber never finishes, its stack is returned to the pool anyway, nothing on it needs destruction
+    }
+
+    if (selected(config, "CoRoutineLights")) {
+        auto const coroutine = pingPong().handle;
+        results.push_back(
+            {"CoRoutineLights", "context_switch", perSwitch(config.inputs, [&]() { coroutine.resume(); }), "ns"});
+        coroutine.destroy();
+    }
+
+    if (selected(config, "ThreadLights")) {
+        // kernel round trips are slow, fewer of them suffice
+        constexpr size_t SLOWDOWN = 100;
+        auto const count = std::max<size_t>(config.inputs / SLOWDOWN, 1);
+        std::atomic<size_t> turn{0};
+        std::thread partner{[&turn, count]() {
+            for (size_t i = 0; i < count; ++i) {
+                turn.wait(2 * i, std::memory_order_acquire);
+                turn.store((2 * i) + 2, std::memory_order_release);
+                turn.notify_one();
+            }
+        }};
+        size_t i = 0;
+        results.push_back({"ThreadLights", "context_switch", perSwitch(count, [&]() {
+                               turn.store((2 * i) + 1, std::memory_order_release);
+                               turn.notify_one();
+                               turn.wait((2 * i) + 1, std::memory_order_acquire);
+                               ++i;
+                           }),
+                           "ns"});
+        partner.join();
+    }
+}
+
+/**
+ * Measure the throughput of one `ThreadLights` instance fed by 1, 4, 16 and 64 producer threads at once, each providing
+ * its share of the RUN inputs one `processInput` call at a time, with the mutex protected queue and with the lock-free
+ * queue. The time includes draining the queue.
+ */
+void benchContention(Config const& config, Workload const& workload, std::vector<Result>& results) {
+    constexpr std::array<size_t, 4> PRODUCERS{1, 4, 16, 64};
+    constexpr std::array<std::pair<std::string_view, ThreadLights::Queue>, 2> QUEUES{{
+        {"ThreadLights", ThreadLights::Queue::Locked},
+        {"ThreadLightsLockFree", ThreadLights::Queue::LockFree},
+    }};
+    for (auto const& [name, queue] : QUEUES) {
+        if (!selected(config, name)) {
+            continue;
+        }
+        for (auto const producers : PRODUCERS) {
+            auto lights = std::make_unique<ThreadLights>(ThreadLights::DEFAULT_CAPACITY, queue);
+            lights->processInputs(workload.init);
+            auto const share = workload.run.size() / producers;
+            std::atomic<bool> go{false};
+            std::vector<std::thread> threads;
+            threads.reserve(producers);
+            for (size_t p = 0; p < producers; ++p) {
+                threads.emplace_back([&lights, &go, inputs = std::span{workload.run}.subspan(p * share, share)]() {
+                    while (!go.load(std::memory_order_acquire)) {
+                        std::this_thread::yield();
+                    }
+                    for (auto const input : inputs) {
+                        lights->processInput(input);
+                    }
+                });
+            }
+            results.push_back({std::string{name}, "contention_" + std::to_string(producers),
+                               throughput(share * producers, [&]() {
+                                   go.store(true, std::memory_order_release);
+                                   for (auto& thread : threads) {
+                                       thread.join();
+                                   }
+                                   // the destructor processes the inputs still queued
+                                   lights.reset();
+                               }),
+                               "inputs/s"});
+        }
+    }
+}
+
+/// Chain of `depth` tasks, each awaiting the next one, returns `depth`.
+Task<size_t> chainTask(size_t depth) {
+    if (depth == 0) {
+        co_return 0;
+    }
+    co_return 1 + co_await chainTask(depth - 1);
+}
+
+/// Await `count` sub-tasks one after the other, returns `count`.
+Task<size_t> awaitTasks(size_t count) {
+    size_t sum = 0;
+    for (size_t i = 0; i < count; ++i) {
+        sum += co_await chainTask(1);
+    }
+    co_return sum;
+}
+
+/**
+ * Measure the cost of composing co-routines with `Task`: awaiting a sub-task, which takes a frame from `FramePool` and
+ * two symmetric transfers, and resuming through a chain of nested tasks, which runs in constant stack space when
+ * optimized. Unoptimized builds use stack space per switch, so both are kept short there.
+ */
+void benchTask(Config const& config, std::vector<Result>& results) {
+    if (!selected(config, "CoRoutineLights")) {
+        return;
+    }
+    auto const perTask = [](size_t count, Task<size_t> task) {
+        auto const start = Clock::now();
+        task.start();
+        if (task.result() != count) {
+            throw std::logic_error{"Task returned wrong result"};
+        }
+        return Nanoseconds{Clock::now() - start}.count() / static_cast<double>(count);
+    };
+    auto awaits = config.inputs;
+    // one frame per level is alive at the deepest point
+    constexpr size_t DEPTH_DIVISOR = 10;
+    auto depth = std::max<size_t>(config.inputs / DEPTH_DIVISOR, 1);
+#ifndef __OPTIMIZE__
+    // symmetric transfer is not a tail call without optimization, every switch nests on the stack, also the switches
+    // back to the awaiting task after each sub-task
+    constexpr size_t MAX_UNOPTIMIZED_NESTING = 1'000;
+    awaits = std::min(awaits, MAX_UNOPTIMIZED_NESTING);
+    depth = std::min(depth, MAX_UNOPTIMIZED_NESTING);
+#endif
+    results.push_back({"CoRoutineLights", "task_await", perTask(awaits, awaitTasks(awaits)), "ns"});
+    results.push_back({"CoRoutineLights", "task_chain", perTask(depth, chainTask(depth)), "ns"});
+}
+
+/// Write results as CSV.
+void writeCsv(std::ostream& out, std::vector<Result> const& results) {
+    out << "implementation,metric,value,unit\n";
+    for (auto const& result : results) {
+        out << result.implementation << "," << result.metric << "," << result.value << "," << result.unit << "\n";
+    }
+}
+
+/// Write configuration and results as JSON.
+void writeJson(std::ostream& out, Config const& config, std::vector<Result> const& results) {
+    out << "{\n"
+        << R"(  "config": {"instances": )" << config.instances << R"(, "inputs": )" << config.inputs
+        << R"(, "seed": )" << config.seed << R"(, "batch": )" << config.batch << "},\n"
+        << R"(  "results": [)";
+    for (size_t i = 0; i < results.size(); ++i) {
+        auto const& result = results[i];
+        out << (i == 0 ? "\n" : ",\n") << R"(    {"implementation": ")" << result.implementation
+            << R"(", "metric": ")" << result.metric << R"(", "value": )" << result.value << R"(, "unit": ")"
+            << result.unit << R"("})";
+    }
+    out << "\n  ]\n}\n";
+}
+
+/// Print usage information.
+void usage(std::string_view name) {
+    std::cerr << "Usage: " << name << " [OPTIONS]\n"
+              << "Options:\n"
+              << "  --instances N   instances for construction, destruction and memory measurements (default 1000)\n"
+              << "  --inputs N      length of the generated RUN input stream (default 1000000)\n"
+              << "  --seed N        seed of the input stream generator (default 1)\n"
+              << "  --batch N       inputs per call for batched throughput (default 1024)\n"
+              << "  --format F      output format, csv or json (default csv)\n"
+              << "  --filter S      only run implementations whose name contains S\n";
+}
+
+/// Parse command line arguments into `config`, return false on error.
+bool parse(std::span<char*> args, Config& config) {
+    for (size_t i = 1; i < args.size(); i += 2) {
+        std::string_view const option = args[i];
+        if (i + 1 >= args.size()) {
+            return false;
+        }
+        std::string const value = args[i + 1];
+        if (option == "--instances") {
+            config.instances = std::stoul(value);
+        } else if (option == "--inputs") {
+            config.inputs = std::max<size_t>(std::stoul(value), 1);
+        } else if (option == "--seed") {
+            config.seed = static_cast<uint32_t>(std::stoul(value));
+        } else if (option == "--batch") {
+            config.batch = std::max<size_t>(std::stoul(value), 1);
+        } else if (option == "--format" && (value == "csv" || value == "json")) {
+            config.format = value;
+        } else if (option == "--filter") {
+            config.filter = value;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    std::span<char*> const args{argv, static_cast<size_t>(argc)};
+    Config config{};
+    try {
+        if (!parse(args, config)) {
+            usage(args[0]);
+            return 1;
+        }
+    } catch (std::exception const& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        usage(args[0]);
+        return 1;
+    }
+
+    Lights::setDefaultSink(nullptr);
+    auto const workload = generate(config);
+
+    std::vector<Result> results{};
+    bench<StateMachineLights>("StateMachineLights", config, workload, results);
+    bench<CoRoutineLights>("CoRoutineLights", config, workload, results);
+    bench<ThreadLights>("ThreadLights", config, workload, results);
+    bench<BenchStaticLights>("StaticLights", config, workload, results);
+    bench<FiberLights>("FiberLights", config, workload, results);
+    benchBank(config, workload, results);
+    benchDispatch<StateMachineLights>("StateMachineLights", config, workload, results);
+    benchDispatch<CoRoutineLights>("CoRoutineLights", config, workload, results);
+    benchDispatch<BenchStaticLights>("StaticLights", config, workload, results);
+    benchSwitch(config, results);
+    benchTask(config, results);
+    benchContention(config, workload, results);
+
+    if (config.format == "json") {
+        writeJson(std::cout, config, results);
+    } else {
+        writeCsv(std::cout, results);
+    }
+    return 0;
+}